@@ -0,0 +1,277 @@
+/* refstat.c
+ *
+ * 读入 Nachos 记录的引用串文件 REFSTRn（格式见 refstr.h），
+ * 对 1 到 m 个帧分别给出 OPT、LRU、FIFO 和时钟算法的页面错误数。
+ *
+ * 只需读一遍引用串：
+ *	OPT 和 LRU 是栈算法，求出每次访问的栈距离后，
+ *	  任意帧数下的页面错误数都可以从距离的分布直接得到；
+ *	FIFO 和时钟不是栈算法（可能出现 Belady 异常），
+ *	  对每个帧数各模拟一份，在同一遍中一起推进。
+ *
+ * 与 Nachos 一样采用纯按需调页，第一次访问某页也算一次页面错误。
+ *
+ * 用法: refstat [-m 最大帧数] REFSTRn
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "refstr.h"
+
+#define NEVER 0x7fffffff	/* 以后不再访问 */
+
+int numPages;			/* 地址空间的页数 */
+int numRefs;			/* 合并后的访问数 */
+int *refPage;			/* 每次访问的页 */
+int *refWrite;			/* 是否有写 */
+int *nextUse;			/* 同一页下一次被访问的位置 */
+long totalRefs;			/* 合并前的访问总数 */
+
+/* 读入引用串，把连续访问同一页的记录合并为一次访问 */
+void ReadRefs(char *fileName)
+{
+    RefStrHeader header;
+    struct stat st;
+    unsigned int *recs;
+    int fd, n, i;
+
+    fd = open(fileName, O_RDONLY, 0);
+    if (fd < 0 || fstat(fd, &st) < 0) {
+	perror(fileName);
+	exit(1);
+    }
+    if (read(fd, &header, sizeof(header)) != sizeof(header)
+	    || header.magic != REFSTRMAGIC) {
+	fprintf(stderr, "%s 不是引用串文件\n", fileName);
+	exit(1);
+    }
+    numPages = header.numPages;
+    n = (st.st_size - sizeof(header)) / sizeof(unsigned int);
+    recs = (unsigned int *) malloc((n + 1) * sizeof(unsigned int));
+    refPage = (int *) malloc((n + 1) * sizeof(int));
+    refWrite = (int *) malloc((n + 1) * sizeof(int));
+    nextUse = (int *) malloc((n + 1) * sizeof(int));
+    if (read(fd, recs, n * sizeof(unsigned int)) != n * sizeof(unsigned int)) {
+	fprintf(stderr, "%s 过短\n", fileName);
+	exit(1);
+    }
+    close(fd);
+
+    numRefs = 0;
+    totalRefs = 0;
+    for (i = 0; i < n; i++) {
+	if (RefPage(recs[i]) >= numPages) {
+	    fprintf(stderr, "%s 中的页号 %d 超出地址空间\n", fileName,
+		    RefPage(recs[i]));
+	    exit(1);
+	}
+	totalRefs += RefCount(recs[i]);
+	if (numRefs > 0 && refPage[numRefs - 1] == RefPage(recs[i])) {
+	    refWrite[numRefs - 1] |= RefIsWrite(recs[i]);
+	    continue;
+	}
+	refPage[numRefs] = RefPage(recs[i]);
+	refWrite[numRefs] = RefIsWrite(recs[i]);
+	numRefs++;
+    }
+    free(recs);
+}
+
+/* 从后向前求出每次访问之后同一页的下一次访问 */
+void ComputeNextUse()
+{
+    int *last = (int *) malloc(numPages * sizeof(int));
+    int i;
+
+    for (i = 0; i < numPages; i++)
+	last[i] = NEVER;
+    for (i = numRefs - 1; i >= 0; i--) {
+	nextUse[i] = last[refPage[i]];
+	last[refPage[i]] = i;
+    }
+    free(last);
+}
+
+/*
+ * 求出 LRU 和 OPT 的栈距离分布。dist[d] 是栈距离为 d（从 1 开始）的
+ * 访问数，dist[0] 是第一次访问的数目。
+ *
+ * LRU 栈按最近使用排列。OPT 栈的第 1 项是刚访问的页，向下逐层
+ * 比较时，下一次访问较早的页留在该层，较晚的继续下移（Mattson）。
+ */
+void StackDistances(long *lruDist, long *optDist)
+{
+    int *lru = (int *) malloc(numPages * sizeof(int));
+    int *opt = (int *) malloc(numPages * sizeof(int));
+    int *prio = (int *) malloc(numPages * sizeof(int));	/* 下一次访问 */
+    int lruLen = 0, optLen = 0;
+    int i, j, k, page, carry, t;
+
+    for (i = 0; i < numRefs; i++) {
+	page = refPage[i];
+
+	for (j = 0; j < lruLen && lru[j] != page; j++)
+	    ;
+	if (j == lruLen)
+	    lruDist[0]++, lruLen++;
+	else
+	    lruDist[j + 1]++;
+	for (; j > 0; j--)
+	    lru[j] = lru[j - 1];
+	lru[0] = page;
+
+	for (j = 0; j < optLen && opt[j] != page; j++)
+	    ;
+	if (j == optLen)
+	    optDist[0]++, optLen++;
+	else
+	    optDist[j + 1]++;
+	prio[page] = nextUse[i];
+	if (j > 0) {
+	    carry = opt[0];
+	    opt[0] = page;
+	    for (k = 1; k < j; k++)
+		if (prio[opt[k]] > prio[carry]) {
+		    t = opt[k];
+		    opt[k] = carry;
+		    carry = t;
+		}
+	    opt[j] = carry;
+	}
+	opt[0] = page;
+    }
+    free(lru);
+    free(opt);
+    free(prio);
+}
+
+/*
+ * 对 1 到 maxFrames 个帧同时模拟 FIFO 和时钟算法，
+ * 记录页面错误数和换出时写回的页数。
+ * 时钟的指针在换入后前进一格，与 Nachos 的 AddrSpace 一致。
+ */
+void Simulate(int maxFrames, long *fifoFaults, long *clockFaults,
+	      long *fifoWrites, long *clockWrites)
+{
+    int f, i, page, victim;
+    int size = maxFrames * numPages;
+    char *fifoIn = (char *) calloc(size, 1);	/* [f][page] 是否在内存中 */
+    char *fifoDirty = (char *) calloc(size, 1);
+    char *clockIn = (char *) calloc(size, 1);
+    char *clockUse = (char *) calloc(size, 1);
+    char *clockDirty = (char *) calloc(size, 1);
+    int *fifoFrame = (int *) malloc(maxFrames * maxFrames * sizeof(int));
+    int *clockFrame = (int *) malloc(maxFrames * maxFrames * sizeof(int));
+    int *fifoHand = (int *) calloc(maxFrames, sizeof(int));
+    int *clockHand = (int *) calloc(maxFrames, sizeof(int));
+    int *used = (int *) calloc(maxFrames, sizeof(int));	/* 已使用的帧数 */
+    int *clockUsed = (int *) calloc(maxFrames, sizeof(int));
+
+    for (i = 0; i < numRefs; i++) {
+	page = refPage[i];
+	for (f = 0; f < maxFrames; f++) {	/* f + 1 个帧 */
+	    char *in = &fifoIn[f * numPages], *dirty = &fifoDirty[f * numPages];
+	    int *frame = &fifoFrame[f * maxFrames];
+
+	    if (!in[page]) {
+		fifoFaults[f]++;
+		if (used[f] < f + 1)
+		    frame[used[f]++] = page;
+		else {
+		    victim = frame[fifoHand[f]];
+		    in[victim] = 0;
+		    if (dirty[victim])
+			fifoWrites[f]++;
+		    dirty[victim] = 0;
+		    frame[fifoHand[f]] = page;
+		    fifoHand[f] = (fifoHand[f] + 1) % (f + 1);
+		}
+		in[page] = 1;
+	    }
+	    if (refWrite[i])
+		dirty[page] = 1;
+
+	    in = &clockIn[f * numPages];
+	    dirty = &clockDirty[f * numPages];
+	    frame = &clockFrame[f * maxFrames];
+	    if (!in[page]) {
+		char *use = &clockUse[f * numPages];
+
+		clockFaults[f]++;
+		if (clockUsed[f] < f + 1)
+		    frame[clockUsed[f]++] = page;
+		else {
+		    while (use[frame[clockHand[f]]]) {
+			use[frame[clockHand[f]]] = 0;
+			clockHand[f] = (clockHand[f] + 1) % (f + 1);
+		    }
+		    victim = frame[clockHand[f]];
+		    in[victim] = 0;
+		    if (dirty[victim])
+			clockWrites[f]++;
+		    dirty[victim] = 0;
+		    frame[clockHand[f]] = page;
+		    clockHand[f] = (clockHand[f] + 1) % (f + 1);
+		}
+		in[page] = 1;
+	    }
+	    clockUse[f * numPages + page] = 1;
+	    if (refWrite[i])
+		dirty[page] = 1;
+	}
+    }
+    free(fifoIn); free(fifoDirty); free(fifoFrame); free(fifoHand);
+    free(clockIn); free(clockUse); free(clockDirty); free(clockFrame);
+    free(clockHand); free(used); free(clockUsed);
+}
+
+int main(int argc, char **argv)
+{
+    int maxFrames = 0;
+    long *lruDist, *optDist, *fifoFaults, *clockFaults;
+    long *fifoWrites, *clockWrites;
+    long lruFaults, optFaults;
+    int f, d;
+
+    if (argc == 4 && !strcmp(argv[1], "-m")) {
+	maxFrames = atoi(argv[2]);
+	argv += 2;
+    } else if (argc != 2) {
+	fprintf(stderr, "用法: refstat [-m 最大帧数] REFSTRn\n");
+	exit(1);
+    }
+    ReadRefs(argv[1]);
+    ComputeNextUse();
+    if (maxFrames <= 0 || maxFrames > numPages)
+	maxFrames = numPages;
+
+    lruDist = (long *) calloc(numPages + 1, sizeof(long));
+    optDist = (long *) calloc(numPages + 1, sizeof(long));
+    fifoFaults = (long *) calloc(maxFrames, sizeof(long));
+    clockFaults = (long *) calloc(maxFrames, sizeof(long));
+    fifoWrites = (long *) calloc(maxFrames, sizeof(long));
+    clockWrites = (long *) calloc(maxFrames, sizeof(long));
+    StackDistances(lruDist, optDist);
+    Simulate(maxFrames, fifoFaults, clockFaults, fifoWrites, clockWrites);
+
+    printf("访问 %ld 次（合并后 %d 次），地址空间 %d 页，访问过 %ld 页\n",
+	   totalRefs, numRefs, numPages, lruDist[0]);
+    printf("帧数      OPT      LRU     FIFO    时钟   FIFO写回 时钟写回\n");
+    for (f = 1; f <= maxFrames; f++) {
+	lruFaults = lruDist[0];
+	optFaults = optDist[0];
+	for (d = f + 1; d <= numPages; d++) {
+	    lruFaults += lruDist[d];
+	    optFaults += optDist[d];
+	}
+	printf("%4d %8ld %8ld %8ld %8ld %8ld %8ld\n", f, optFaults, lruFaults,
+	       fifoFaults[f - 1], clockFaults[f - 1],
+	       fifoWrites[f - 1], clockWrites[f - 1]);
+    }
+    return 0;
+}
@@ -0,0 +1,29 @@
+/* refstr.h
+ *     定义引用串文件 REFSTRn 的格式。
+ *
+ *     Nachos 在 lab7 中用 -pra 的负值记录用户进程的页引用串，
+ *     refstat 读入同一个文件，离线比较各种页置换算法。
+ *
+ *     文件以 RefStrHeader 开头，之后是一串 32 位的记录（主机字节序）。
+ *     连续访问同一页（读写相同）合并为一条记录：
+ *	位 31..8  虚拟页号
+ *	位 7      是否为写
+ *	位 6..0   连续访问的次数减一（1 到 128 次）
+ */
+
+#define REFSTRMAGIC 0x52454653 /* 魔数 "REFS" */
+
+#define RefMaxRun 128 /* 一条记录最多合并的访问次数 */
+
+#define RefRecord(vpn, writing, count) \
+  (((unsigned int)(vpn) << 8) | ((writing) ? 0x80 : 0) | ((count) - 1))
+#define RefPage(rec) ((int)((rec) >> 8))
+#define RefIsWrite(rec) (((rec) & 0x80) != 0)
+#define RefCount(rec) ((int)((rec) & 0x7f) + 1)
+
+typedef struct refStrHeader
+{
+  int magic;    /* 应该是 REFSTRMAGIC */
+  int pageSize; /* 页大小（字节） */
+  int numPages; /* 地址空间的页数，虚拟页号都小于它 */
+} RefStrHeader;
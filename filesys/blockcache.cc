@@ -0,0 +1,236 @@
+// blockcache.cc
+//	管理磁盘扇区缓存的例程。
+//
+//	未命中时从缓冲区中选出最久未使用且没有线程在用的一个；
+//	如果它是脏的，先写回原来的扇区，再装入新的扇区。
+//	写回时只持有该缓冲区的锁，其他线程可以继续使用缓存；
+//	写回完成前它仍缓存原来的扇区，要访问该扇区的线程会在
+//	缓冲区锁上等待，不会从磁盘读到旧的内容。
+//
+//	写入总是覆盖整个扇区，所以写未命中时不必先从磁盘读取。
+//
+
+
+#include "blockcache.h"
+#include "synchdisk.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// BlockCache::BlockCache
+// 	初始化一个空的扇区缓存。
+//
+//	"cacheDisk" -- 未命中和写回时使用的磁盘
+//	"size" -- 缓存的扇区数
+//----------------------------------------------------------------------
+
+BlockCache::BlockCache(SynchDisk *cacheDisk, int size)
+{
+    int i;
+
+    ASSERT(size > 0);
+    disk = cacheDisk;
+    numBuffers = size;
+    buffers = new CacheBuffer[numBuffers];
+    head = tail = NULL;
+    for (i = 0; i < numBuffers; i++) {
+	buffers[i].sector = -1;
+	buffers[i].dirty = FALSE;
+	buffers[i].users = 0;
+	buffers[i].lock = new Lock("缓冲区锁");
+	buffers[i].prev = tail;		// 依次加到链尾
+	buffers[i].next = NULL;
+	if (tail != NULL)
+	    tail->next = &buffers[i];
+	else
+	    head = &buffers[i];
+	tail = &buffers[i];
+    }
+    bySector = new CacheBuffer *[NumSectors];
+    for (i = 0; i < NumSectors; i++)
+	bySector[i] = NULL;
+    lock = new Lock("扇区缓存锁");
+    bufferFree = new Condition("扇区缓存空闲");
+}
+
+//----------------------------------------------------------------------
+// BlockCache::~BlockCache
+// 	释放扇区缓存。脏缓冲区不会被写回，调用者应先调用 Flush。
+//----------------------------------------------------------------------
+
+BlockCache::~BlockCache()
+{
+    for (int i = 0; i < numBuffers; i++)
+	delete buffers[i].lock;
+    delete [] buffers;
+    delete [] bySector;
+    delete lock;
+    delete bufferFree;
+}
+
+//----------------------------------------------------------------------
+// BlockCache::ReadSector
+// 	通过缓存读取一个扇区。
+//
+//	"sectorNumber" -- 要读取的磁盘扇区
+//	"data" -- 用于保存扇区内容的缓冲区
+//----------------------------------------------------------------------
+
+void
+BlockCache::ReadSector(int sectorNumber, char* data)
+{
+    CacheBuffer *buf = Get(sectorNumber, TRUE);
+
+    bcopy(buf->data, data, SectorSize);
+    Put(buf);
+}
+
+//----------------------------------------------------------------------
+// BlockCache::WriteSector
+// 	通过缓存写入一个扇区。只修改缓存中的副本，
+//	被替换或 Flush 时才写到磁盘。
+//
+//	"sectorNumber" -- 要写入的磁盘扇区
+//	"data" -- 扇区的新内容
+//----------------------------------------------------------------------
+
+void
+BlockCache::WriteSector(int sectorNumber, char* data)
+{
+    CacheBuffer *buf = Get(sectorNumber, FALSE);
+
+    bcopy(data, buf->data, SectorSize);
+    buf->dirty = TRUE;
+    Put(buf);
+}
+
+//----------------------------------------------------------------------
+// BlockCache::Flush
+// 	把所有脏缓冲区写回磁盘。
+//----------------------------------------------------------------------
+
+void
+BlockCache::Flush()
+{
+    CacheBuffer *buf;
+
+    for (int i = 0; i < numBuffers; i++) {
+	buf = &buffers[i];
+	lock->Acquire();
+	if (buf->sector < 0) {
+	    lock->Release();
+	    continue;
+	}
+	buf->users++;			// 防止它在写回前被替换
+	lock->Release();
+	buf->lock->Acquire();		// 等待正在使用它的线程
+	if (buf->dirty) {
+	    disk->WriteSectorUncached(buf->sector, buf->data);
+	    buf->dirty = FALSE;
+	    stats->numCacheWriteBacks++;
+	}
+	Put(buf);
+    }
+}
+
+//----------------------------------------------------------------------
+// BlockCache::Get
+// 	返回缓存 "sectorNumber" 的缓冲区，必要时替换一个缓冲区。
+//	返回时持有该缓冲区的锁，调用者用完后调用 Put。
+//
+//	"sectorNumber" -- 要访问的扇区
+//	"fill" -- 未命中时是否从磁盘读入扇区的内容
+//		（调用者要覆盖整个扇区时不必读入）
+//----------------------------------------------------------------------
+
+CacheBuffer *
+BlockCache::Get(int sectorNumber, bool fill)
+{
+    CacheBuffer *buf;
+
+    ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
+    lock->Acquire();
+    for (;;) {
+	buf = bySector[sectorNumber];
+	if (buf != NULL) {		// 命中
+	    stats->numCacheHits++;
+	    buf->users++;
+	    MoveToFront(buf);
+	    lock->Release();
+	    buf->lock->Acquire();	// 可能要等装入它的线程完成
+	    return buf;
+	}
+	for (buf = tail; buf != NULL; buf = buf->prev)
+	    if (buf->users == 0)	// 最久未使用的空闲缓冲区
+		break;
+	if (buf == NULL) {
+	    bufferFree->Wait(lock);	// 其他线程可能同时装入了该扇区，
+	    continue;			// 醒来后重新查找
+	}
+	buf->users = 1;
+	buf->lock->Acquire();		// users 为 0，没有线程持有它
+	if (buf->sector < 0 || !buf->dirty)
+	    break;
+
+	lock->Release();		// 写回时不持有缓存锁
+	disk->WriteSectorUncached(buf->sector, buf->data);
+	buf->dirty = FALSE;
+	stats->numCacheWriteBacks++;
+	lock->Acquire();
+	if (buf->users == 1 && bySector[sectorNumber] == NULL)
+	    break;
+	buf->users--;			// 写回期间有线程要访问原来的扇区，
+	buf->lock->Release();		// 或者其他线程已装入了该扇区：
+	if (buf->users == 0)		// 保留它，重新查找
+	    bufferFree->Signal(lock);
+    }
+
+    stats->numCacheMisses++;
+    if (buf->sector >= 0)
+	bySector[buf->sector] = NULL;
+    buf->sector = sectorNumber;
+    buf->dirty = FALSE;
+    bySector[sectorNumber] = buf;
+    MoveToFront(buf);
+    lock->Release();
+
+    if (fill)				// 其他线程在缓冲区锁上等待装入完成
+	disk->ReadSectorUncached(sectorNumber, buf->data);
+    return buf;
+}
+
+//----------------------------------------------------------------------
+// BlockCache::Put
+// 	结束对缓冲区的使用，释放它的锁。
+//----------------------------------------------------------------------
+
+void
+BlockCache::Put(CacheBuffer *buf)
+{
+    buf->lock->Release();
+    lock->Acquire();
+    buf->users--;
+    if (buf->users == 0)
+	bufferFree->Signal(lock);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// BlockCache::MoveToFront
+// 	把缓冲区移到 LRU 链的表头。调用者持有缓存锁。
+//----------------------------------------------------------------------
+
+void
+BlockCache::MoveToFront(CacheBuffer *buf)
+{
+    if (buf == head)
+	return;
+    buf->prev->next = buf->next;	// 从链中取下
+    if (buf->next != NULL)
+	buf->next->prev = buf->prev;
+    else
+	tail = buf->prev;
+    buf->prev = NULL;			// 放到表头
+    buf->next = head;
+    head->prev = buf;
+    head = buf;
+}
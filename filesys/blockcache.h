@@ -0,0 +1,74 @@
+// blockcache.h
+// 	磁盘扇区缓存的数据结构。
+//
+//	缓存位于 SynchDisk 之内，保存最近使用的若干扇区。读取命中时
+//	不访问磁盘；写入只修改缓存中的副本并标记为脏（写回），
+//	直到该缓冲区被替换或调用 Flush 时才写到磁盘。
+//	缓冲区满时替换最久未使用（LRU）的一个。
+//
+//	每个缓冲区有自己的锁，因此不同线程访问不同扇区时
+//	互不阻塞；缓存本身的锁只保护查找表和 LRU 链。
+//
+
+
+
+#ifndef BLOCKCACHE_H
+#define BLOCKCACHE_H
+
+#include "disk.h"
+#include "synch.h"
+
+class SynchDisk;
+
+// 以下类定义了缓存中的一个缓冲区，保存一个扇区的副本。
+
+class CacheBuffer {
+  public:
+    int sector;				// 缓存的扇区号，-1 表示空
+    bool dirty;				// 副本是否比磁盘上的新
+    int users;				// 正在使用该缓冲区的线程数，
+					// 为 0 时才可被替换
+    Lock *lock;				// 保护 data 和 dirty
+    CacheBuffer *prev;			// LRU 链，表头为最近使用
+    CacheBuffer *next;
+    char data[SectorSize];		// 扇区的内容
+};
+
+// 以下类定义了一个写回的 LRU 扇区缓存。
+//
+// 持有缓存锁时只获取 users 为 0 的缓冲区的锁，这时没有线程持有它；
+// 其他缓冲区先把 users 加一，释放缓存锁后再获取它的锁。因此持有
+// 缓冲区锁的线程可以再去获取缓存锁，不会死锁。
+
+class BlockCache {
+  public:
+    BlockCache(SynchDisk *cacheDisk, int size);
+					// 初始化一个有 "size" 个
+					// 缓冲区的空缓存
+    ~BlockCache();			// 释放缓存；调用者应先 Flush
+					// （SynchDisk 的析构函数会这样做）
+
+    void ReadSector(int sectorNumber, char* data);
+    void WriteSector(int sectorNumber, char* data);
+					// 通过缓存读取/写入一个扇区
+    void Flush();			// 把所有脏缓冲区写回磁盘
+
+  private:
+    SynchDisk *disk;			// 未命中和写回时使用
+    CacheBuffer *buffers;		// 所有缓冲区
+    int numBuffers;
+    CacheBuffer **bySector;		// 扇区号 -> 缓冲区，未缓存时为 NULL
+    CacheBuffer *head;			// LRU 链：最近使用
+    CacheBuffer *tail;			// LRU 链：最久未使用
+    Lock *lock;				// 保护 bySector、LRU 链，
+					// 以及缓冲区的 sector 和 users
+    Condition *bufferFree;		// 所有缓冲区都在使用时在此等待
+
+    CacheBuffer *Get(int sectorNumber, bool fill);
+					// 找到或装入一个扇区，返回时
+					// 持有该缓冲区的锁
+    void Put(CacheBuffer *buf);		// 结束对缓冲区的使用
+    void MoveToFront(CacheBuffer *buf);	// 标记为最近使用
+};
+
+#endif // BLOCKCACHE_H
@@ -1,8 +1,11 @@
 // filehdr.cc 
 //	管理磁盘文件头的例程（在 UNIX 中，这被称为 i-node）。
 //
-//	文件头用于定位文件数据在磁盘上的存储位置。我们将其实现为一个固定大小的指针表——表中的每个条目指向包含该部分文件数据的磁盘扇区
-//	（换句话说，没有间接或双重间接块）。表的大小选择为文件头刚好足够放入一个磁盘扇区，
+//	文件头用于定位文件数据在磁盘上的存储位置。我们将其实现为一个固定大小的盘区表——
+//	每个盘区是文件中的一段，在磁盘上连续存放（没有间接块）。
+//	表的大小选择为文件头刚好足够放入一个磁盘扇区。
+//	分配时尽量使用长的连续空闲扇区，因此顺序读写大多不必换道，
+//	文件的长度也不再受表的大小限制。
 //
 //	与真实系统不同，我们不在文件头中跟踪文件权限、所有权、最后修改日期等信息。
 //
@@ -21,6 +24,11 @@
 //	从空闲磁盘块的映射中分配数据块给文件。
 //	如果没有足够的空闲块来容纳新文件，则返回 FALSE。
 //
+//	先尝试把剩余的扇区一次分配为一个盘区；找不到足够长的
+//	连续空闲扇区时把长度减半再找。位图按 next-fit 查找，
+//	依次创建的文件在磁盘上顺序排列。最后一个盘区必须放下
+//	剩余的全部扇区，否则空闲空间太零碎，分配失败。
+//
 //	"freeMap" 是空闲磁盘扇区的位图
 //	"fileSize" 是文件大小
 //----------------------------------------------------------------------
@@ -28,13 +36,35 @@
 bool
 FileHeader::Allocate(BitMap *freeMap, int fileSize)
 { 
+    int numSectors = divRoundUp(fileSize, SectorSize);
+    int remaining, length, start;
+
     numBytes = fileSize;
-    numSectors  = divRoundUp(fileSize, SectorSize);
+    numExtents = 0;
     if (freeMap->NumClear() < numSectors)
 	return FALSE;		// 空间不足
 
-    for (int i = 0; i < numSectors; i++)
-	dataSectors[i] = freeMap->Find();
+    for (remaining = numSectors; remaining > 0; remaining -= length) {
+	length = remaining;
+	start = freeMap->FindRange(length);
+	while (start == -1 && numExtents < NumExtents - 1 && length > 1) {
+	    length /= 2;
+	    start = freeMap->FindRange(length);
+	}
+	if (start == -1) {
+	    Deallocate(freeMap);	// 盘区不够用，放弃已分配的部分
+	    return FALSE;
+	}
+	if (numExtents > 0 && extents[numExtents - 1].start
+			+ extents[numExtents - 1].length == start)
+	    extents[numExtents - 1].length += length;	// 与上一个盘区相接
+	else {
+	    extents[numExtents].first = numSectors - remaining;
+	    extents[numExtents].start = start;
+	    extents[numExtents].length = length;
+	    numExtents++;
+	}
+    }
     return TRUE;
 }
 
@@ -48,10 +78,12 @@ FileHeader::Allocate(BitMap *freeMap, int fileSize)
 void 
 FileHeader::Deallocate(BitMap *freeMap)
 {
-    for (int i = 0; i < numSectors; i++) {
-	ASSERT(freeMap->Test((int) dataSectors[i]));  // 应该被标记！
-	freeMap->Clear((int) dataSectors[i]);
-    }
+    for (int i = 0; i < numExtents; i++)
+	for (int j = 0; j < extents[i].length; j++) {
+	    ASSERT(freeMap->Test(extents[i].start + j));  // 应该被标记！
+	    freeMap->Clear(extents[i].start + j);
+	}
+    numExtents = 0;
 }
 
 //----------------------------------------------------------------------
@@ -91,7 +123,50 @@ FileHeader::WriteBack(int sector)
 int
 FileHeader::ByteToSector(int offset)
 {
-    return(dataSectors[offset / SectorSize]);
+    int sector = offset / SectorSize;
+    Extent *e = &extents[FindExtent(sector)];
+
+    return e->start + (sector - e->first);
+}
+
+//----------------------------------------------------------------------
+// FileHeader::ContiguousSectors
+// 	返回从包含 "offset" 的扇区起，到所在盘区结束为止的扇区数。
+//	这些扇区在磁盘上是连续的，可以一次传输。
+//
+//	"offset" 是文件中该字节的位置
+//----------------------------------------------------------------------
+
+int
+FileHeader::ContiguousSectors(int offset)
+{
+    int sector = offset / SectorSize;
+    Extent *e = &extents[FindExtent(sector)];
+
+    return e->first + e->length - sector;
+}
+
+//----------------------------------------------------------------------
+// FileHeader::FindExtent
+// 	返回包含文件中第 "sector" 个扇区的盘区的下标。
+//	盘区按 first 递增排列，二分查找最后一个 first 不大于
+//	"sector" 的盘区。
+//----------------------------------------------------------------------
+
+int
+FileHeader::FindExtent(int sector)
+{
+    int low = 0, high = numExtents - 1, mid;
+
+    ASSERT(numExtents > 0 && sector < divRoundUp(numBytes, SectorSize));
+    while (low < high) {
+	mid = (low + high + 1) / 2;
+	if (extents[mid].first <= sector)
+	    low = mid;
+	else
+	    high = mid - 1;
+    }
+    return low;
 }
 
 //----------------------------------------------------------------------
@@ -113,15 +188,16 @@ FileHeader::FileLength()
 void
 FileHeader::Print()
 {
-    int i, j, k;
+    int i, j, k, n;
     char *data = new char[SectorSize];
 
     printf("文件头内容。文件大小: %d. 文件块:\n", numBytes);
-    for (i = 0; i < numSectors; i++)
-	printf("%d ", dataSectors[i]);
+    for (i = 0; i < numExtents; i++)
+	for (j = 0; j < extents[i].length; j++)
+	    printf("%d ", extents[i].start + j);
     printf("\n文件内容:\n");
-    for (i = k = 0; i < numSectors; i++) {
-	synchDisk->ReadSector(dataSectors[i], data);
+    for (n = k = 0; k < numBytes; n++) {
+	synchDisk->ReadSector(ByteToSector(n * SectorSize), data);
         for (j = 0; (j < SectorSize) && (k < numBytes); j++, k++) {
 	    if ('\040' <= data[j] && data[j] <= '\176')   // isprint(data[j])
 		printf("%c", data[j]);
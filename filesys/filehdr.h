@@ -14,19 +14,29 @@
 #include "disk.h"
 #include "bitmap.h"
 
-#define NumDirect 	(int)((SectorSize - 2 * sizeof(int)) / sizeof(int))
-#define MaxFileSize 	(NumDirect * SectorSize)
+// 盘区（extent）：文件中从第 "first" 个扇区开始的 "length" 个扇区，
+// 在磁盘上连续存放在从 "start" 开始的扇区中。
+
+class Extent {
+  public:
+    int first;				// 第一个扇区在文件中的序号
+    int start;				// 第一个扇区在磁盘上的扇区号
+    int length;				// 扇区数
+};
+
+#define NumExtents 	(int)((SectorSize - 2 * sizeof(int)) / sizeof(Extent))
+#define MaxFileSize 	(NumSectors * SectorSize)
 
 // 以下类定义了Nachos的“文件头”（在UNIX术语中，  
 // “i-node”），描述了在磁盘上找到文件中所有数据的位置。
-// 文件头组织为一个简单的指针表，指向
-// 数据块。 
+// 文件头组织为一个按文件中的顺序排列的盘区表，
+// 每个盘区是磁盘上一段连续的扇区。
 //
 // 文件头数据结构可以存储在内存中或磁盘上。
 // 当它在磁盘上时，它存储在一个单一的扇区中——这意味着
 // 我们假设这个数据结构的大小与一个磁盘扇区相同。 
-// 没有间接寻址，这
-// 限制了最大文件长度为不到4K字节。
+// 文件的长度只受盘区数的限制：分配时尽量使用连续的扇区，
+// 空闲空间足够连续时整个文件只占一个盘区。
 //
 // 没有构造函数；而是文件头可以通过为文件分配块（
 // 如果是新文件）或通过
@@ -47,6 +57,8 @@ class FileHeader {
     int ByteToSector(int offset);	// 将字节偏移量转换为文件
 					// 所在的磁盘扇区
 					// 包含该字节
+    int ContiguousSectors(int offset);	// 从包含该字节的扇区起，
+					// 磁盘上连续的扇区数
 
     int FileLength();			// 返回文件的长度 
 					// 以字节为单位
@@ -55,9 +67,11 @@ class FileHeader {
 
   private:
     int numBytes;			// 文件中的字节数
-    int numSectors;			// 文件中的数据扇区数
-    int dataSectors[NumDirect];		// 每个数据块在磁盘上的扇区号 
-					// 在文件中
+    int numExtents;			// 使用中的盘区数
+    Extent extents[NumExtents];		// 按文件中的顺序排列的盘区
+
+    int FindExtent(int sector);		// 包含文件中第 "sector" 个扇区的
+					// 盘区，二分查找
 };
 
 #endif // FILEHDR_H
@@ -91,11 +91,14 @@ OpenFile::Write(char *into, int numBytes)
 //	扇区。因此：
 //
 //	对于 ReadAt：
-//	   我们读取所有完整或部分扇区，但只复制我们感兴趣的部分。
+//	   部分扇区读入一个扇区大小的临时缓冲区，只复制我们
+//	   感兴趣的部分；完整的扇区直接读入调用者的缓冲区。
 //	对于 WriteAt：
 //	   我们必须首先读取任何将被部分写入的扇区，
-//	   以便不覆盖未修改的部分。然后我们复制
-//	   要修改的数据，并写回所有完整或部分扇区。
+//	   以便不覆盖未修改的部分，修改后再写回。
+//	   完整的扇区直接从调用者的缓冲区写出。
+//
+//	完整扇区中物理上连续的一段合并为一次多扇区请求。
 //
 //	"into" -- 用于从磁盘读取数据的缓冲区 
 //	"from" -- 包含要写入磁盘的数据的缓冲区 
@@ -107,8 +110,8 @@ int
 OpenFile::ReadAt(char *into, int numBytes, int position)
 {
     int fileLength = hdr->FileLength();
-    int i, firstSector, lastSector, numSectors;
-    char *buf;
+    int offset, end, inSector, chunk, sector, count;
+    char buf[SectorSize];
 
     if ((numBytes <= 0) || (position >= fileLength))
     	return 0; 				// 检查请求
@@ -117,19 +120,22 @@ OpenFile::ReadAt(char *into, int numBytes, int position)
     DEBUG('f', "正在读取 %d 字节，位置 %d，文件长度 %d.\n", 	
 			numBytes, position, fileLength);
 
-    firstSector = divRoundDown(position, SectorSize);
-    lastSector = divRoundDown(position + numBytes - 1, SectorSize);
-    numSectors = 1 + lastSector - firstSector;
-
-    // 读取我们需要的所有完整和部分扇区
-    buf = new char[numSectors * SectorSize];
-    for (i = firstSector; i <= lastSector; i++)	
-        synchDisk->ReadSector(hdr->ByteToSector(i * SectorSize), 
-					&buf[(i - firstSector) * SectorSize]);
-
-    // 复制我们想要的部分
-    bcopy(&buf[position - (firstSector * SectorSize)], into, numBytes);
-    delete [] buf;
+    end = position + numBytes;
+    for (offset = position; offset < end; offset += chunk) {
+	inSector = offset % SectorSize;
+	sector = hdr->ByteToSector(offset);
+	if (inSector != 0 || end - offset < SectorSize) {
+	    // 部分扇区：读入临时缓冲区，复制我们想要的部分
+	    chunk = min(SectorSize - inSector, end - offset);
+	    synchDisk->ReadSector(sector, buf);
+	    bcopy(&buf[inSector], &into[offset - position], chunk);
+	} else {
+	    // 完整扇区：合并物理上连续的扇区，直接读入
+	    count = ContiguousSectors(offset, end, sector);
+	    chunk = count * SectorSize;
+	    synchDisk->ReadSectors(sector, count, &into[offset - position]);
+	}
+    }
     return numBytes;
 }
 
@@ -137,9 +143,8 @@ int
 OpenFile::WriteAt(char *from, int numBytes, int position)
 {
     int fileLength = hdr->FileLength();
-    int i, firstSector, lastSector, numSectors;
-    bool firstAligned, lastAligned;
-    char *buf;
+    int offset, end, inSector, chunk, sector, count;
+    char buf[SectorSize];
 
     if ((numBytes <= 0) || (position >= fileLength))  // 对于原始的 Nachos 文件系统
 //    if ((numBytes <= 0) || (position > fileLength))  // 对于 lab4 ...
@@ -149,31 +154,43 @@ OpenFile::WriteAt(char *from, int numBytes, int position)
     DEBUG('f', "正在写入 %d 字节，位置 %d，文件长度 %d.\n", 	
 			numBytes, position, fileLength);
 
-    firstSector = divRoundDown(position, SectorSize);
-    lastSector = divRoundDown(position + numBytes - 1, SectorSize);
-    numSectors = 1 + lastSector - firstSector;
-
-    buf = new char[numSectors * SectorSize];
-
-    firstAligned = (bool)(position == (firstSector * SectorSize));
-    lastAligned = (bool)((position + numBytes) == ((lastSector + 1) * SectorSize));
+    end = position + numBytes;
+    for (offset = position; offset < end; offset += chunk) {
+	inSector = offset % SectorSize;
+	sector = hdr->ByteToSector(offset);
+	if (inSector != 0 || end - offset < SectorSize) {
+	    // 部分扇区：读出整个扇区，复制我们想要更改的字节后写回
+	    chunk = min(SectorSize - inSector, end - offset);
+	    synchDisk->ReadSector(sector, buf);
+	    bcopy(&from[offset - position], &buf[inSector], chunk);
+	    synchDisk->WriteSector(sector, buf);
+	} else {
+	    // 完整扇区：合并物理上连续的扇区，直接写出
+	    count = ContiguousSectors(offset, end, sector);
+	    chunk = count * SectorSize;
+	    synchDisk->WriteSectors(sector, count, &from[offset - position]);
+	}
+    }
+    return numBytes;
+}
 
-// 如果要部分修改，则读取第一个和最后一个扇区
-    if (!firstAligned)
-        ReadAt(buf, SectorSize, firstSector * SectorSize);	
-    if (!lastAligned && ((firstSector != lastSector) || firstAligned))
-        ReadAt(&buf[(lastSector - firstSector) * SectorSize], 
-				SectorSize, lastSector * SectorSize);	
+//----------------------------------------------------------------------
+// OpenFile::ContiguousSectors
+// 	从文件中扇区对齐的 "offset" 开始（它位于磁盘扇区 "sector"），
+//	返回 [offset, end) 中有多少个完整扇区在磁盘上也是连续的。
+//	至少为 1。同一个盘区中的扇区总是连续的，相邻的盘区
+//	也可能在磁盘上相接。
+//----------------------------------------------------------------------
 
-// 复制我们想要更改的字节 
-    bcopy(from, &buf[position - (firstSector * SectorSize)], numBytes);
+int
+OpenFile::ContiguousSectors(int offset, int end, int sector)
+{
+    int count = hdr->ContiguousSectors(offset);
 
-// 写回修改后的扇区
-    for (i = firstSector; i <= lastSector; i++)	
-        synchDisk->WriteSector(hdr->ByteToSector(i * SectorSize), 
-					&buf[(i - firstSector) * SectorSize]);
-    delete [] buf;
-    return numBytes;
+    while (offset + count * SectorSize < end
+	    && hdr->ByteToSector(offset + count * SectorSize) == sector + count)
+	count += hdr->ContiguousSectors(offset + count * SectorSize);
+    return min(count, (end - offset) / SectorSize);
 }
 
 //----------------------------------------------------------------------
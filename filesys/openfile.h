@@ -92,6 +92,9 @@ public:
 private:
 	FileHeader *hdr;  // 此文件的头部
 	int seekPosition; // 文件中的当前位置
+
+	int ContiguousSectors(int offset, int end, int sector);
+	// 从 "offset" 起在磁盘上连续的完整扇区数
 };
 
 #endif // FILESYS
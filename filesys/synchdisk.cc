@@ -4,13 +4,19 @@
 //	中断稍后发生）。这是在磁盘之上提供的一个层，
 //	提供同步接口（请求等待直到请求完成）。
 //
-//	使用信号量来同步中断处理程序与
-//	待处理请求。并且，由于物理磁盘只能
-//	同时处理一个操作，因此使用锁来强制互斥。
+//	每个请求有自己的信号量，用来同步中断处理程序与
+//	发出请求的线程。由于物理磁盘只能同时处理一个操作，
+//	磁盘忙时新的请求进入等待队列；每当一个请求完成，
+//	中断处理程序就按调度策略发出下一个。队列与中断处理
+//	程序共享，因此用关中断而不是锁来保护。
+//
+//	如果启用了扇区缓存，读写先经过缓存（见 blockcache.cc），
+//	缓存未命中或写回时才使用上述的磁盘请求。
 //
 
 
 #include "synchdisk.h"
+#include "system.h"
 
 //----------------------------------------------------------------------
 // DiskRequestDone
@@ -33,25 +39,38 @@ DiskRequestDone (_int arg)
 //
 //	"name" -- 用作磁盘数据存储的UNIX文件名
 //	   （通常为 "DISK"）
+//	"cacheSectors" -- 扇区缓存的大小，0 表示不使用缓存
+//	"schedPolicy" -- 等待的磁盘请求的调度策略
+//	"tracks", "trackSectors" -- 大于 0 时按此几何参数重新创建磁盘，
+//	   否则使用磁盘映像中记录的几何参数
 //----------------------------------------------------------------------
 
-SynchDisk::SynchDisk(const char* name)
+SynchDisk::SynchDisk(const char* name, int cacheSectors,
+		     DiskSchedPolicy schedPolicy, int tracks, int trackSectors)
 {
-    semaphore = new Semaphore("同步磁盘", 0);
-    lock = new Lock("同步磁盘锁");
-    disk = new Disk(name, DiskRequestDone, (_int) this);
+    disk = new Disk(name, DiskRequestDone, (_int) this, tracks,
+		    trackSectors);
+    policy = schedPolicy;
+    queue = current = NULL;
+    headSector = 0;			// 与 Disk 的初始位置一致
+    headUp = TRUE;
+    buffers = new char *[NumSectors];
+    cache = NULL;
+    if (cacheSectors > 0)
+	cache = new BlockCache(this, cacheSectors);
 }
 
 //----------------------------------------------------------------------
 // SynchDisk::~SynchDisk
 // 	释放同步磁盘抽象所需的数据结构。
+//	缓存中的脏扇区不会写回，调用者应先 Flush。
 //----------------------------------------------------------------------
 
 SynchDisk::~SynchDisk()
 {
+    delete cache;
     delete disk;
-    delete lock;
-    delete semaphore;
+    delete [] buffers;
 }
 
 //----------------------------------------------------------------------
@@ -65,15 +84,16 @@ SynchDisk::~SynchDisk()
 void
 SynchDisk::ReadSector(int sectorNumber, char* data)
 {
-    lock->Acquire();			// 每次只能进行一个磁盘I/O
-    disk->ReadRequest(sectorNumber, data);
-    semaphore->P();			// 等待中断
-    lock->Release();
+    if (cache != NULL)
+	cache->ReadSector(sectorNumber, data);
+    else
+	ReadSectorUncached(sectorNumber, data);
 }
 
 //----------------------------------------------------------------------
 // SynchDisk::WriteSector
-// 	将缓冲区的内容写入磁盘扇区。只有在数据被写入后才返回。
+// 	将缓冲区的内容写入磁盘扇区。使用缓存时只写入缓存，
+//	否则只有在数据被写入后才返回。
 //
 //	"sectorNumber" -- 要写入的磁盘扇区
 //	"data" -- 磁盘扇区的新内容
@@ -82,20 +102,271 @@ SynchDisk::ReadSector(int sectorNumber, char* data)
 void
 SynchDisk::WriteSector(int sectorNumber, char* data)
 {
-    lock->Acquire();			// 每次只能进行一个磁盘I/O
-    disk->WriteRequest(sectorNumber, data);
-    semaphore->P();			// 等待中断
-    lock->Release();
+    if (cache != NULL)
+	cache->WriteSector(sectorNumber, data);
+    else
+	WriteSectorUncached(sectorNumber, data);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::ReadSectors
+// 	读取连续的若干个扇区。只有在数据全部被读取后才返回。
+//	不使用缓存时作为一个多扇区磁盘请求发出，只寻道一次；
+//	使用缓存时逐个扇区经过缓存，以免读到比缓存旧的内容。
+//
+//	"firstSector" -- 第一个要读取的扇区
+//	"numSectors" -- 扇区数
+//	"data" -- 用于保存扇区内容的缓冲区，至少 numSectors * SectorSize 字节
+//----------------------------------------------------------------------
+
+void
+SynchDisk::ReadSectors(int firstSector, int numSectors, char* data)
+{
+    if (cache != NULL) {
+	for (int i = 0; i < numSectors; i++)
+	    cache->ReadSector(firstSector + i, &data[i * SectorSize]);
+	return;
+    }
+
+    Submit(firstSector, numSectors, data, FALSE);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::WriteSectors
+// 	写入连续的若干个扇区。只有在数据全部被写入（或进入缓存）后才返回。
+//	与 ReadSectors 一样，不使用缓存时只发出一个磁盘请求。
+//
+//	"firstSector" -- 第一个要写入的扇区
+//	"numSectors" -- 扇区数
+//	"data" -- 扇区的新内容，numSectors * SectorSize 字节
+//----------------------------------------------------------------------
+
+void
+SynchDisk::WriteSectors(int firstSector, int numSectors, char* data)
+{
+    if (cache != NULL) {
+	for (int i = 0; i < numSectors; i++)
+	    cache->WriteSector(firstSector + i, &data[i * SectorSize]);
+	return;
+    }
+
+    Submit(firstSector, numSectors, data, TRUE);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Flush
+// 	把缓存中所有的脏扇区写回磁盘。不使用缓存时什么也不做。
+//----------------------------------------------------------------------
+
+void
+SynchDisk::Flush()
+{
+    if (cache != NULL)
+	cache->Flush();
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::ReadSectorUncached
+// 	绕过缓存，将磁盘扇区的内容读取到缓冲区中。
+//	只有在数据被读取后才返回。
+//
+//	"sectorNumber" -- 要读取的磁盘扇区
+//	"data" -- 用于保存磁盘扇区内容的缓冲区
+//----------------------------------------------------------------------
+
+void
+SynchDisk::ReadSectorUncached(int sectorNumber, char* data)
+{
+    Submit(sectorNumber, 1, data, FALSE);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::WriteSectorUncached
+// 	绕过缓存，将缓冲区的内容写入磁盘扇区。
+//	只有在数据被写入后才返回。
+//
+//	"sectorNumber" -- 要写入的磁盘扇区
+//	"data" -- 磁盘扇区的新内容
+//----------------------------------------------------------------------
+
+void
+SynchDisk::WriteSectorUncached(int sectorNumber, char* data)
+{
+    Submit(sectorNumber, 1, data, TRUE);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Submit
+// 	把一个请求加入等待队列，磁盘空闲时立即发出，
+//	然后等待它完成。
+//
+//	"firstSector" -- 第一个扇区
+//	"numSectors" -- 连续的扇区数
+//	"data" -- 读入或写出的数据，numSectors * SectorSize 字节
+//	"writing" -- 是否为写请求
+//----------------------------------------------------------------------
+
+void
+SynchDisk::Submit(int firstSector, int numSectors, char* data, bool writing)
+{
+    DiskRequest req;
+    DiskRequest **tail;
+    IntStatus oldLevel;
+
+    req.sector = firstSector;
+    req.numSectors = numSectors;
+    req.data = data;
+    req.writing = writing;
+    req.issueTime = stats->totalTicks;
+    req.done = new Semaphore("磁盘请求", 0);
+    req.next = NULL;
+
+    oldLevel = interrupt->SetLevel(IntOff);
+    for (tail = &queue; *tail != NULL; tail = &(*tail)->next)
+	;
+    *tail = &req;
+    if (current == NULL)		// 磁盘空闲
+	StartNext();
+    (void) interrupt->SetLevel(oldLevel);
+
+    req.done->P();			// 等待中断
+    delete req.done;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::StartNext
+// 	按调度策略从等待队列中选出一个请求，再把方向相同、
+//	与它首尾相接的请求一个个合并进来，作为一个多扇区请求
+//	发给磁盘。调用时中断是关闭的，队列不为空，磁盘空闲。
+//----------------------------------------------------------------------
+
+void
+SynchDisk::StartNext()
+{
+    DiskRequest *first, *last, *r, **prev;
+    int start, end, n;
+    bool merged;
+
+    first = last = PickNext();
+    first->next = NULL;
+    start = first->sector;
+    end = first->sector + first->numSectors;
+    do {
+	merged = FALSE;
+	for (prev = &queue; (r = *prev) != NULL; prev = &r->next) {
+	    if (r->writing != first->writing)
+		continue;
+	    if (r->sector == end) {		// 接在后面
+		*prev = r->next;
+		r->next = NULL;
+		last->next = r;
+		last = r;
+		end += r->numSectors;
+		merged = TRUE;
+		break;
+	    }
+	    if (r->sector + r->numSectors == start) {	// 接在前面
+		*prev = r->next;
+		r->next = first;
+		first = r;
+		start = r->sector;
+		merged = TRUE;
+		break;
+	    }
+	}
+    } while (merged);
+
+    n = 0;
+    for (r = first; r != NULL; r = r->next)
+	for (int i = 0; i < r->numSectors; i++)
+	    buffers[n++] = &r->data[i * SectorSize];
+    current = first;
+    headSector = end - 1;
+    if (first->writing)
+	disk->WriteRequestV(start, n, buffers);
+    else
+	disk->ReadRequestV(start, n, buffers);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::PickNext
+// 	按调度策略从等待队列中取出下一个要做的请求。
+//	调用时中断是关闭的，队列不为空。
+//
+//	SSTF 和 SCAN 以磁头所在的位置（上一组请求的最后一个扇区）
+//	为准；SSTF 只比较轨道距离，同一轨道上先到的请求优先。
+//	这两种策略都可能让远处的请求等待很久。
+//----------------------------------------------------------------------
+
+DiskRequest *
+SynchDisk::PickNext()
+{
+    DiskRequest *best = queue, *lowest, *r, **prev;
+    int headTrack = headSector / sectorsPerTrack;
+
+    switch (policy) {
+      case DiskFCFS:
+	break;
+      case DiskSSTF:
+	for (r = queue; r != NULL; r = r->next)
+	    if (abs(r->sector / sectorsPerTrack - headTrack) <
+		    abs(best->sector / sectorsPerTrack - headTrack))
+		best = r;
+	break;
+      case DiskSCAN:
+	best = NULL;
+	for (int pass = 0; (pass < 2) && (best == NULL); pass++) {
+	    for (r = queue; r != NULL; r = r->next) {
+		if (headUp ? (r->sector < headSector)
+			   : (r->sector > headSector))
+		    continue;			// 在磁头后方
+		if ((best == NULL) || (abs(r->sector - headSector) <
+					abs(best->sector - headSector)))
+		    best = r;
+	    }
+	    if (best == NULL)
+		headUp = !headUp;		// 前方没有请求，掉头
+	}
+	break;
+      case DiskCLOOK:
+	best = NULL;
+	lowest = queue;
+	for (r = queue; r != NULL; r = r->next) {
+	    if (r->sector < lowest->sector)
+		lowest = r;
+	    if ((r->sector >= headSector) &&
+		    ((best == NULL) || (r->sector < best->sector)))
+		best = r;
+	}
+	if (best == NULL)			// 前方没有请求，跳回
+	    best = lowest;
+	break;
+    }
+
+    for (prev = &queue; *prev != best; prev = &(*prev)->next)
+	;
+    *prev = best->next;
+    return best;
 }
 
 //----------------------------------------------------------------------
 // SynchDisk::RequestDone
-// 	磁盘中断处理程序。唤醒任何等待磁盘
-//	请求完成的线程。
+// 	磁盘中断处理程序。唤醒等待刚完成的这组请求的线程，
+//	如果还有等待的请求，发出下一组。
 //----------------------------------------------------------------------
 
 void
 SynchDisk::RequestDone()
 { 
-    semaphore->V();
+    DiskRequest *r, *next;
+
+    for (r = current; r != NULL; r = next) {
+	next = r->next;
+	stats->numDiskRequests++;
+	stats->diskRequestTicks += stats->totalTicks - r->issueTime;
+	r->done->V();
+    }
+    current = NULL;
+    if (queue != NULL)
+	StartNext();
 }
@@ -9,6 +9,32 @@
 
 #include "disk.h"
 #include "synch.h"
+#include "blockcache.h"
+
+// 磁盘请求的调度策略：磁盘空闲后，从等待的请求中选哪一个先做。
+enum DiskSchedPolicy {
+    DiskFCFS,				// 先来先服务
+    DiskSSTF,				// 最短寻道时间优先
+    DiskSCAN,				// 电梯算法：沿当前方向前进，
+					// 前方没有请求时掉头
+    DiskCLOOK				// 只向扇区号增大的方向前进，
+					// 到头后跳回最小的请求
+};
+
+// 以下类定义了一个等待磁盘的请求。请求由发出它的线程在
+// 栈上构造（见 SynchDisk::Submit），完成前该线程一直在
+// "done" 上等待。
+
+class DiskRequest {
+  public:
+    int sector;				// 第一个扇区
+    int numSectors;			// 连续的扇区数
+    char *data;				// numSectors * SectorSize 字节
+    bool writing;			// 写请求还是读请求
+    int issueTime;			// 提交时的 totalTicks
+    Semaphore *done;			// 请求完成时 V
+    DiskRequest *next;			// 等待队列或正在进行的一组请求
+};
 
 // 以下类定义了一个“同步”磁盘抽象。
 // 与其他I/O设备一样，原始物理磁盘是一个异步设备 --
@@ -19,10 +45,25 @@
 //
 // 该类提供了抽象，对于任何单独的线程
 // 发出请求时，它会等待操作完成后再返回。
+//
+// 可以在磁盘之上加一层写回的扇区缓存（见 blockcache.h）。
+// 此时 ReadSector/WriteSector 经过缓存，写入的数据直到被替换
+// 或调用 Flush 时才到达磁盘。
+//
+// 磁盘忙时，其他线程的请求进入等待队列。磁盘空闲后按调度
+// 策略选出下一个请求，并把队列中方向相同、扇区紧邻的请求
+// 合并成一个多扇区请求一起发给磁盘。
 class SynchDisk {
   public:
-    SynchDisk(const char* name);    		// 初始化一个同步磁盘，
+    SynchDisk(const char* name, int cacheSectors = 0,
+	      DiskSchedPolicy schedPolicy = DiskFCFS,
+	      int tracks = 0, int trackSectors = 0);
+    					// 初始化一个同步磁盘，
 					// 通过初始化原始磁盘。
+					// "cacheSectors" 大于 0 时
+					// 使用这么多扇区的缓存。
+					// "tracks" 大于 0 时按新的
+					// 几何参数重新创建磁盘。
     ~SynchDisk();			// 释放同步磁盘数据
     
     void ReadSector(int sectorNumber, char* data);
@@ -33,16 +74,42 @@ class SynchDisk {
 					// 然后等待请求完成。
     void WriteSector(int sectorNumber, char* data);
     
+    void ReadSectors(int firstSector, int numSectors, char* data);
+    void WriteSectors(int firstSector, int numSectors, char* data);
+    					// 读取/写入从 "firstSector" 开始的
+					// 连续 "numSectors" 个扇区
+    
+    void Flush();			// 把缓存中的脏扇区写回磁盘
+
+    void MapDisk(DiskSyncPolicy sync) { disk->MapImage(sync); }
+					// 把磁盘映像映射到内存
+
+    void ReadSectorUncached(int sectorNumber, char* data);
+    void WriteSectorUncached(int sectorNumber, char* data);
+					// 绕过缓存直接读写磁盘，
+					// 由 BlockCache 使用
+
     void RequestDone();			// 由磁盘设备中断
 					// 处理程序调用，以信号
 					// 当前磁盘操作已完成。
 
   private:
     Disk *disk;		  		// 原始磁盘设备
-    Semaphore *semaphore; 		// 用于同步请求线程 
-					// 与中断处理程序
-    Lock *lock;		  		// 只能向磁盘发送一个读/写请求
-					// 一次
+    BlockCache *cache;			// 扇区缓存，不使用时为 NULL
+    DiskSchedPolicy policy;		// 请求的调度策略
+    DiskRequest *queue;			// 等待的请求，按到达顺序；
+    					// 与中断处理程序共享，
+					// 只在关中断时访问
+    DiskRequest *current;		// 正在进行的一组请求，按扇区
+					// 递增链接；磁盘空闲时为 NULL
+    int headSector;			// 上一组请求的最后一个扇区
+    bool headUp;			// SCAN 时磁头的移动方向
+    char **buffers;			// 发给磁盘的每个扇区的缓冲区
+
+    void Submit(int firstSector, int numSectors, char* data,
+		bool writing);		// 排队并等待请求完成
+    void StartNext();			// 选出下一组请求发给磁盘
+    DiskRequest *PickNext();		// 按调度策略从队列中取出一个
 };
 
 #endif // SYNCHDISK_H
@@ -0,0 +1,107 @@
+// dentry.cc
+
+#include "utility.h"
+#include "dentry.h"
+
+DentryCache::DentryCache(int size)
+{
+    int i;
+
+    numEntries = size;
+    entries = new Dentry[numEntries];
+    for (i = 0; i < numEntries; i++)
+    {
+        entries[i].parent = -1;
+        entries[i].lastUse = 0;
+        entries[i].hashNext = -1;
+    }
+    for (numBuckets = 16; numBuckets < numEntries; numBuckets *= 2)
+        ;
+    buckets = new int[numBuckets];
+    for (i = 0; i < numBuckets; i++)
+        buckets[i] = -1;
+    clock = 0;
+}
+
+DentryCache::~DentryCache()
+{
+    delete[] entries;
+    delete[] buckets;
+}
+
+int DentryCache::Bucket(int parent, char *name)
+{
+    return (HashFileName(name) + parent * 17) & (numBuckets - 1);
+}
+
+int DentryCache::FindIndex(int parent, char *name)
+{
+    int i = buckets[Bucket(parent, name)];
+
+    for (; i != -1; i = entries[i].hashNext)
+        if (entries[i].parent == parent &&
+            !strncmp(entries[i].name, name, FileNameMaxLen))
+            return i;
+    return -1;
+}
+
+void DentryCache::Unlink(int i)
+{
+    int *prev = &buckets[Bucket(entries[i].parent, entries[i].name)];
+
+    for (; *prev != i; prev = &entries[*prev].hashNext)
+        ;
+    *prev = entries[i].hashNext;
+    entries[i].parent = -1;
+}
+
+bool DentryCache::Lookup(int parent, char *name, int *sector, bool *isDir)
+{
+    int i = FindIndex(parent, name);
+
+    if (i == -1)
+    {
+        DEBUG('f', "路径缓存未命中: %d/%s\n", parent, name);
+        return FALSE;
+    }
+    entries[i].lastUse = ++clock;
+    *sector = entries[i].sector;
+    *isDir = entries[i].isDir;
+    return TRUE;
+}
+
+void DentryCache::Enter(int parent, char *name, int sector, bool isDir)
+{
+    int i = FindIndex(parent, name);
+    int b;
+
+    if (i == -1)
+    {
+        for (int j = 0; j < numEntries; j++) // 空闲的项，或者最久未使用的项
+            if (entries[j].parent == -1)
+            {
+                i = j;
+                break;
+            }
+            else if (i == -1 || entries[j].lastUse < entries[i].lastUse)
+                i = j;
+        if (entries[i].parent != -1)
+            Unlink(i);
+        entries[i].parent = parent;
+        memset(entries[i].name, 0, sizeof(entries[i].name));
+        strncpy(entries[i].name, name, FileNameMaxLen);
+        b = Bucket(parent, name);
+        entries[i].hashNext = buckets[b];
+        buckets[b] = i;
+    }
+    entries[i].sector = sector;
+    entries[i].isDir = isDir;
+    entries[i].lastUse = ++clock;
+}
+
+void DentryCache::Purge(int parent)
+{
+    for (int i = 0; i < numEntries; i++)
+        if (entries[i].parent == parent)
+            Unlink(i);
+}
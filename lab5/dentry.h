@@ -0,0 +1,47 @@
+// lab5
+// dentry.h
+// 路径查找的缓存：(所在目录的文件头扇区, 名称) -> 文件头扇区。
+// 沿路径逐级查找时命中缓存就不必读入中间的目录；
+// 查找失败的结果也会缓存（否定项）。
+// 缓存满时替换最久未使用的一项。
+
+#ifndef DENTRY_H
+#define DENTRY_H
+
+#include "directory.h"
+
+class Dentry
+{
+public:
+  int parent;                     // 所在目录的文件头扇区，-1 表示空闲
+  char name[FileNameMaxLen + 1];
+  int sector;                     // 文件头扇区，-1 表示不存在（否定项）
+  bool isDir;
+  int lastUse;                    // 最近一次使用的时间
+  int hashNext;                   // 同一个桶中的下一项，-1 表示没有
+};
+
+class DentryCache
+{
+public:
+  DentryCache(int size);
+  ~DentryCache();
+
+  // 命中时返回 TRUE，*sector 为 -1 表示已知不存在
+  bool Lookup(int parent, char *name, int *sector, bool *isDir);
+  void Enter(int parent, char *name, int sector, bool isDir); // 加入或更新一项
+  void Purge(int parent); // 删除目录 parent 下的所有项，删除目录时调用
+
+private:
+  Dentry *entries;
+  int numEntries;
+  int *buckets; // 每个桶中第一项的下标，-1 表示空
+  int numBuckets;
+  int clock;    // 每次使用加一
+
+  int FindIndex(int parent, char *name);
+  int Bucket(int parent, char *name);
+  void Unlink(int i); // 从散列链中取下
+};
+
+#endif // DENTRY_H
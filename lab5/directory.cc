@@ -4,12 +4,29 @@
 #include "filehdr.h"
 #include "directory.h"
 
+// 读入文件头在 sector 中的子目录
+static Directory *FetchSubdirectory(int sector)
+{
+    OpenFile *file = new OpenFile(sector);
+    Directory *dir = new Directory(0);
+
+    dir->FetchFrom(file);
+    delete file;
+    return dir;
+}
+
 int Directory::GetAllFileSize()
 {
     int size = 0;
     for (int i = 0; i < tableSize; i++)
-        if (table[i].inUse)
+        if (table[i].type == FileEntry)
             size += GetFileSize(i);
+        else if (table[i].type == DirEntry)
+        {
+            Directory *sub = FetchSubdirectory(table[i].sector);
+            size += sub->GetAllFileSize();
+            delete sub;
+        }
     return size;
 }
 
@@ -17,8 +34,14 @@ int Directory::GetAllFileSectors()
 {
     int sectors = 0;
     for (int i = 0; i < tableSize; i++)
-        if (table[i].inUse)
+        if (table[i].type == FileEntry)
             sectors += GetFileSectors(i);
+        else if (table[i].type == DirEntry)
+        {
+            Directory *sub = FetchSubdirectory(table[i].sector);
+            sectors += sub->GetAllFileSectors();
+            delete sub;
+        }
     return sectors;
 }
 
@@ -44,38 +67,142 @@ int Directory::GetFileNum()
 {
     int num = 0;
     for (int i = 0; i < tableSize; i++)
-        if (table[i].inUse)
+        if (table[i].type == FileEntry)
             num++;
+        else if (table[i].type == DirEntry)
+        {
+            Directory *sub = FetchSubdirectory(table[i].sector);
+            num += sub->GetFileNum();
+            delete sub;
+        }
     return num;
 }
 
+// 目录文件最多能容纳的目录项数
+#define MaxDirEntries (int)(MaxFileSize / sizeof(DirectoryEntry))
+
 Directory::Directory(int size)
 {
-    table = new DirectoryEntry[size];
-    tableSize = size;
-    for (int i = 0; i < tableSize; i++)
-        table[i].inUse = FALSE;
+    table = NULL;
+    buckets = chain = NULL;
+    tableSize = 0;
+    Resize(size);
+    dirtyLow = 0; // 新目录的所有目录项都要写到磁盘
+    dirtyHigh = tableSize;
 }
 
 Directory::~Directory()
 {
     delete[] table;
+    delete[] buckets;
+    delete[] chain;
+}
+
+void Directory::Resize(int newSize)
+{
+    DirectoryEntry *newTable = new DirectoryEntry[newSize];
+    int i;
+
+    for (i = 0; i < newSize; i++)
+        if (i < tableSize)
+            newTable[i] = table[i];
+        else
+        {
+            memset(&newTable[i], 0, sizeof(DirectoryEntry));
+            newTable[i].type = FreeEntry;
+        }
+    delete[] table;
+    table = newTable;
+    tableSize = newSize;
+    Rehash();
+}
+
+void Directory::Rehash()
+{
+    int i, b;
+
+    delete[] buckets;
+    delete[] chain;
+    for (numBuckets = 16; numBuckets < tableSize; numBuckets *= 2)
+        ;
+    buckets = new int[numBuckets];
+    chain = new int[tableSize];
+    for (b = 0; b < numBuckets; b++)
+        buckets[b] = -1;
+    numUsed = 0;
+    freeHint = tableSize;
+    for (i = tableSize - 1; i >= 0; i--) // 倒序插入，桶内按下标递增
+        if (table[i].type != FreeEntry)
+        {
+            b = HashFileName(table[i].name) & (numBuckets - 1);
+            chain[i] = buckets[b];
+            buckets[b] = i;
+            numUsed++;
+        }
+        else
+            freeHint = i;
+}
+
+void Directory::MarkDirty(int i)
+{
+    if (dirtyLow >= dirtyHigh)
+    {
+        dirtyLow = i;
+        dirtyHigh = i + 1;
+    }
+    else
+    {
+        dirtyLow = min(dirtyLow, i);
+        dirtyHigh = max(dirtyHigh, i + 1);
+    }
 }
 
 void Directory::FetchFrom(OpenFile *file)
 {
+    delete[] table;
+    tableSize = file->Length() / sizeof(DirectoryEntry);
+    table = new DirectoryEntry[tableSize];
     (void)file->ReadAt((char *)table, tableSize * sizeof(DirectoryEntry), 0);
+    Rehash();
+    dirtyLow = dirtyHigh = 0;
 }
 
 void Directory::WriteBack(OpenFile *file)
 {
-    (void)file->WriteAt((char *)table, tableSize * sizeof(DirectoryEntry), 0);
+    if (dirtyLow >= dirtyHigh)
+        return;
+    (void)file->WriteAt((char *)&table[dirtyLow],
+                        (dirtyHigh - dirtyLow) * sizeof(DirectoryEntry),
+                        dirtyLow * sizeof(DirectoryEntry));
+    dirtyLow = dirtyHigh = 0;
+}
+
+// 把目录文件扩大一倍（不超过文件的最大长度），新的目录项为空。
+// 新的部分立即写到磁盘，调用者之后应写回目录文件的文件头
+bool Directory::Grow(OpenFile *file)
+{
+    int oldSize = tableSize;
+    int newSize = min(max(tableSize * 2, 1), MaxDirEntries);
+    int bytes = (newSize - oldSize) * sizeof(DirectoryEntry);
+
+    if (newSize <= oldSize)
+        return FALSE; // 已达到最大长度
+    Resize(newSize);
+    if (file->WriteAt((char *)&table[oldSize], bytes,
+                      oldSize * sizeof(DirectoryEntry)) < bytes)
+    {
+        Resize(oldSize); // 磁盘空间不足，目录文件没有变长
+        return FALSE;
+    }
+    return TRUE;
 }
 
 int Directory::FindIndex(char *name)
 {
-    for (int i = 0; i < tableSize; i++)
-        if (table[i].inUse && !strncmp(table[i].name, name, FileNameMaxLen))
+    int i = buckets[HashFileName(name) & (numBuckets - 1)];
+
+    for (; i != -1; i = chain[i])
+        if (!strncmp(table[i].name, name, FileNameMaxLen))
             return i;
     return -1; // 名称不在目录中
 }
@@ -89,37 +216,57 @@ int Directory::Find(char *name)
     return -1;
 }
 
-bool Directory::Add(char *name, int newSector)
+bool Directory::IsDirectory(char *name)
 {
-    if (FindIndex(name) != -1)
-        return FALSE;
+    int i = FindIndex(name);
 
-    for (int i = 0; i < tableSize; i++)
-        if (!table[i].inUse)
-        {
-            table[i].inUse = TRUE;
-            strncpy(table[i].name, name, FileNameMaxLen);
-            table[i].sector = newSector;
-            return TRUE;
-        }
-    return FALSE; // 没有空间。修复当我们有可扩展文件时。
+    return i != -1 && table[i].type == DirEntry;
+}
+
+bool Directory::Add(char *name, int newSector, bool isDir)
+{
+    int i, b;
+
+    if (FindIndex(name) != -1 || IsFull())
+        return FALSE; // 没有空间时由调用者先调用 Grow
+
+    for (i = freeHint; table[i].type != FreeEntry; i++) // 与原来一样使用第一个空闲的目录项
+        ;
+    freeHint = i + 1;
+    table[i].type = isDir ? DirEntry : FileEntry;
+    memset(table[i].name, 0, sizeof(table[i].name));
+    strncpy(table[i].name, name, FileNameMaxLen);
+    table[i].sector = newSector;
+    b = HashFileName(table[i].name) & (numBuckets - 1);
+    chain[i] = buckets[b];
+    buckets[b] = i;
+    numUsed++;
+    MarkDirty(i);
+    return TRUE;
 }
 
 bool Directory::Remove(char *name)
 {
     int i = FindIndex(name);
+    int *prev;
 
     if (i == -1)
         return FALSE; // 名称不在目录中
-    table[i].inUse = FALSE;
+    for (prev = &buckets[HashFileName(name) & (numBuckets - 1)]; *prev != i; prev = &chain[*prev])
+        ;
+    *prev = chain[i];
+    table[i].type = FreeEntry;
+    numUsed--;
+    freeHint = min(freeHint, i);
+    MarkDirty(i);
     return TRUE;
 }
 
 void Directory::List()
 {
     for (int i = 0; i < tableSize; i++)
-        if (table[i].inUse)
-            printf("%s\n", table[i].name);
+        if (table[i].type != FreeEntry)
+            printf("%s%s\n", table[i].name, table[i].type == DirEntry ? "/" : "");
 }
 
 void Directory::Print()
@@ -128,9 +275,10 @@ void Directory::Print()
 
     printf("目录内容:\n");
     for (int i = 0; i < tableSize; i++)
-        if (table[i].inUse)
+        if (table[i].type != FreeEntry)
         {
-            printf("名称: %s, 扇区: %d\n", table[i].name, table[i].sector);
+            printf("名称: %s%s, 扇区: %d\n", table[i].name,
+                   table[i].type == DirEntry ? "/" : "", table[i].sector);
             hdr->FetchFrom(table[i].sector);
             hdr->Print();
         }
@@ -1,6 +1,10 @@
 // lab5
 // directory.h 修改自 filesys/directory.h
 // 提供获取文件大小和盘区数目的方法
+// 目录文件仍是 DirectoryEntry 的数组，但长度不再固定：表满时
+// 目录文件按倍数增长。内存中另有一个按名称散列的索引，
+// 查找、添加和删除都不必扫描整个表。
+// 目录项可以指向子目录，子目录的内容同样是一个目录文件。
 
 #ifndef DIRECTORY_H
 #define DIRECTORY_H
@@ -9,10 +13,16 @@
 
 #define FileNameMaxLen 9
 
+// 目录项的类型。FileEntry 与原来 inUse 为真时的取值相同，
+// 旧的磁盘映像不用转换
+#define FreeEntry 0
+#define FileEntry 1
+#define DirEntry 2
+
 class DirectoryEntry
 {
 public:
-  bool inUse;
+  char type; // FreeEntry、FileEntry 或 DirEntry
   int sector;
   char name[FileNameMaxLen + 1];
 };
@@ -23,18 +33,23 @@ public:
   Directory(int size);
   ~Directory();
 
-  void FetchFrom(OpenFile *file);
-  void WriteBack(OpenFile *file);
+  void FetchFrom(OpenFile *file); // 读入整个目录文件，重建散列索引
+  void WriteBack(OpenFile *file); // 只写回上次写回后修改过的目录项
 
   int Find(char *name);
+  bool IsDirectory(char *name); // name 是否是一个子目录
 
-  bool Add(char *name, int newSector);
+  bool Add(char *name, int newSector, bool isDir = FALSE);
+  bool IsFull() { return numUsed == tableSize; } // 没有空闲的目录项
+  bool IsEmpty() { return numUsed == 0; }
+  bool Grow(OpenFile *file); // 扩大目录文件，返回是否成功
 
   bool Remove(char *name);
 
   void List();
   void Print();
 
+  // 以下统计包括各级子目录中的普通文件
   int GetFileNum();
   int GetFileSectors(int index);
   int GetFileSize(int index);
@@ -45,7 +60,28 @@ private:
   int tableSize;
   DirectoryEntry *table;
 
+  // 以下只在内存中
+  int numBuckets;        // 散列桶数，2 的幂，不小于 tableSize
+  int *buckets;          // 每个桶中第一个目录项的下标，-1 表示空
+  int *chain;            // 同一个桶中下一个目录项的下标，-1 表示没有
+  int numUsed;           // 使用中的目录项数
+  int freeHint;          // 下标比它小的目录项都在使用中
+  int dirtyLow;          // 修改过的目录项范围 [dirtyLow, dirtyHigh)
+  int dirtyHigh;
+
   int FindIndex(char *name);
+  void Resize(int newSize); // 改变表的大小，新增的目录项为空
+  void Rehash();            // 根据 table 重建散列索引
+  void MarkDirty(int i);
 };
 
+// 只看前 FileNameMaxLen 个字符，与 Directory::Find 的比较一致
+inline unsigned HashFileName(char *name)
+{
+  unsigned hash = 0;
+  for (int i = 0; i < FileNameMaxLen && name[i] != '\0'; i++)
+    hash = hash * 31 + (unsigned char)name[i];
+  return hash;
+}
+
 #endif // DIRECTORY_H
@@ -1,8 +1,7 @@
 // filehdr.cc 更改自lab4/filehdr.cc
-// 获取二级索引
-// 设置二级索引
 // 获取盘号
-// 更改文件大小时，判断是否使用二级索引
+// 前 NumDirect 个扇区直接索引，之后依次使用一级、二级、三级间接索引
+// 索引块在第一次使用时读入并缓存在文件头中，修改后才写回
 // 分配空间
 // 回收空间
 // print
@@ -23,84 +22,200 @@
 //     return permissions;
 // }
 
-// 更改文件大小
-bool FileHeader::ChangeFileSize(int fileSize)
+// 第 level 级间接索引能容纳的数据扇区数
+static int Span(int level)
 {
-    // 空闲扇区
-    BitMap *freeMap = new BitMap(NumSectors);
-    OpenFile *bitMapFile = new OpenFile(0);
-    freeMap->FetchFrom(bitMapFile);
-    int numSectors = this->numSectors();
-    int numSectorsSet = divRoundUp(fileSize, SectorSize);
+    int span = 1;
+    for (int i = 0; i < level; i++)
+        span *= NumIndirect;
+    return span;
+}
 
-    // 空间不足
-    if (freeMap->NumClear() < (numSectorsSet - numSectors))
-        return false;
+// 文件有 sectors 个数据扇区时需要的索引块数
+static int IndexBlocks(int sectors)
+{
+    int n = sectors - NumDirect;
+    int blocks = 0;
+    for (int level = 1; level <= NumLevels && n > 0; level++)
+    {
+        int m = min(n, Span(level));
+        for (int k = 1; k <= level; k++)
+            blocks += divRoundUp(m, Span(k));
+        n -= m;
+    }
+    return blocks;
+}
 
-    this->numBytes = fileSize;
+IndexBlock::IndexBlock(int blockSector, int blockLevel, bool fresh)
+{
+    sector = blockSector;
+    level = blockLevel;
+    dirty = fresh;
+    if (fresh)
+        memset(entries, 0, sizeof(entries));
+    else
+        synchDisk->ReadSector(sector, (char *)entries);
+    children = NULL;
+    if (level > 1)
+    {
+        children = new IndexBlock *[NumIndirect];
+        memset(children, 0, NumIndirect * sizeof(IndexBlock *));
+    }
+}
 
-    // 分配空闲扇区
-    if (this->ifIndirect())
-        this->indirectSector = freeMap->Find();
-    int *indirect = this->GetIndirect();
-    for (numSectors; numSectors < numSectorsSet; numSectors++)
-        if (numSectors < NumDirect)
+IndexBlock::~IndexBlock()
+{
+    if (children == NULL)
+        return;
+    for (int i = 0; i < NumIndirect; i++)
+        delete children[i];
+    delete[] children;
+}
+
+// 第 i 个间接索引（i 为 0、1、2）的根
+IndexBlock *FileHeader::Root(int i, BitMap *freeMap)
+{
+    if (index[i] == NULL)
+    {
+        if (indexSectors[i] != 0)
+            index[i] = new IndexBlock(indexSectors[i], i + 1, false);
+        else if (freeMap != NULL)
         {
-            dataSectors[numSectors] = freeMap->Find();
+            indexSectors[i] = freeMap->Find();
+            index[i] = new IndexBlock(indexSectors[i], i + 1, true);
         }
-        else
+    }
+    return index[i];
+}
+
+// 索引块 block 的第 i 个下一级索引块
+IndexBlock *FileHeader::Child(IndexBlock *block, int i, BitMap *freeMap)
+{
+    if (block->children[i] == NULL)
+    {
+        if (block->entries[i] != 0)
+            block->children[i] = new IndexBlock(block->entries[i], block->level - 1, false);
+        else if (freeMap != NULL)
         {
-            indirect[numSectors - NumDirect] = freeMap->Find();
+            block->entries[i] = freeMap->Find();
+            block->dirty = true;
+            block->children[i] = new IndexBlock(block->entries[i], block->level - 1, true);
         }
-    this->SetIndirect(indirect);
-    freeMap->WriteBack(bitMapFile);
-    return true;
+    }
+    return block->children[i];
 }
 
-bool FileHeader::Allocate(BitMap *freeMap, int fileSize)
+// 返回保存文件第 n 个数据扇区号的位置
+// freeMap 不为 NULL 时沿途分配缺少的索引块，并认为最后一级索引块将被修改
+int *FileHeader::SectorSlot(int n, BitMap *freeMap)
+{
+    IndexBlock *block;
+    int level, span;
+
+    if (n < NumDirect)
+        return &dataSectors[n];
+    n -= NumDirect;
+    for (level = 1; n >= Span(level); level++)
+        n -= Span(level);
+    ASSERT(level <= NumLevels);
+    block = Root(level - 1, freeMap);
+    for (span = Span(level); block->level > 1; n %= span)
+    {
+        span /= NumIndirect;
+        block = Child(block, n / span, freeMap);
+    }
+    if (freeMap != NULL)
+        block->dirty = true;
+    return &block->entries[n];
+}
+
+void FileHeader::FlushIndex(IndexBlock *block)
+{
+    if (block == NULL)
+        return;
+    if (block->dirty)
+    {
+        synchDisk->WriteSector(block->sector, (char *)block->entries);
+        block->dirty = false;
+    }
+    if (block->children != NULL)
+        for (int i = 0; i < NumIndirect; i++)
+            FlushIndex(block->children[i]);
+}
+
+void FileHeader::FreeIndex(IndexBlock *block, int count, BitMap *freeMap)
+{
+    if (block->level == 1)
+        for (int i = 0; i < count; i++)
+            freeMap->Clear(block->entries[i]);
+    else
+    {
+        int span = Span(block->level - 1);
+        for (int i = 0; count > 0; i++, count -= span)
+            FreeIndex(Child(block, i, NULL), min(count, span), freeMap);
+    }
+    freeMap->Clear(block->sector);
+}
+
+void FileHeader::DropIndex()
+{
+    for (int i = 0; i < NumLevels; i++)
+    {
+        delete index[i];
+        index[i] = NULL;
+    }
+}
+
+// 更改文件大小，从 freeMap 中分配新增的扇区和需要的索引块
+// freeMap 是文件系统常驻内存的位图，由调用者负责写回
+bool FileHeader::ChangeFileSize(BitMap *freeMap, int fileSize)
 {
     int numSectors = this->numSectors();
     int numSectorsSet = divRoundUp(fileSize, SectorSize);
 
     // 空间不足
-    if (freeMap->NumClear() < (numSectorsSet - numSectors))
+    if (numSectorsSet > MaxSectorNum ||
+        freeMap->NumClear() < (numSectorsSet - numSectors) +
+                                  (IndexBlocks(numSectorsSet) - IndexBlocks(numSectors)))
         return false;
 
     this->numBytes = fileSize;
 
     // 分配空闲扇区
-    if (this->ifIndirect()){
-        printf("*****启用二级索引*****\n%d", this->indirectSector);
-        this->indirectSector = freeMap->Find();}
-    int *indirect = this->GetIndirect();
-    for (numSectors; numSectors < numSectorsSet; numSectors++)
-        if (numSectors < NumDirect)
-        {
-            dataSectors[numSectors] = freeMap->Find();
-        }
-        else
-        {
-            indirect[numSectors - NumDirect] = freeMap->Find();
-        }
-    this->SetIndirect(indirect);
+    for (; numSectors < numSectorsSet; numSectors++)
+        *SectorSlot(numSectors, freeMap) = freeMap->Find();
+    for (int i = 0; i < NumLevels; i++)
+        FlushIndex(index[i]);
+    return true;
+}
+
+bool FileHeader::Allocate(BitMap *freeMap, int fileSize)
+{
+    bool indirect = divRoundUp(fileSize, SectorSize) > NumDirect && indexSectors[0] == 0;
+
+    if (!ChangeFileSize(freeMap, fileSize))
+        return false;
+    if (indirect)
+        DEBUG('f', "启用一级间接索引，索引块在扇区 %d\n", indexSectors[0]);
     return true;
 }
 
+// 按索引树释放，每个索引块只读入一次
 void FileHeader::Deallocate(BitMap *freeMap)
 {
-    int i = 0;
-    int numSectors = this->numSectors();
-    int *indirect = this->GetIndirect();
-    for (i; i < numSectors; i++)
-        // 一级索引
-        if (i < NumDirect)
-            freeMap->Clear((int)dataSectors[i]);
-        // 二级索引
-        else
-            freeMap->Clear((int)indirect[i - NumDirect]);
-    if (this->ifIndirect())
-        freeMap->Clear((int)indirectSector);
-    this->indirectSector = 0;
+    int n = this->numSectors();
+    int i;
+
+    for (i = 0; i < n && i < NumDirect; i++)
+        freeMap->Clear((int)dataSectors[i]);
+    n -= NumDirect;
+    for (i = 0; i < NumLevels && n > 0; i++)
+    {
+        FreeIndex(Root(i, NULL), min(n, Span(i + 1)), freeMap);
+        n -= Span(i + 1);
+    }
+    DropIndex(); // 索引块已释放
+    memset(indexSectors, 0, sizeof(indexSectors));
     return;
 }
 
@@ -111,22 +226,15 @@ void FileHeader::Print()
 
     printf("文件块:\n");
     int numSectors = this->numSectors();
-    int *indirect = this->GetIndirect();
     for (int i = 0; i < numSectors; i++)
-        if (i < NumDirect)
-            printf("%d ", dataSectors[i]);
-        else
-            printf("%d ", indirect[i - NumDirect]);
+        printf("%d ", ByteToSector(i * SectorSize));
 
     printf("\n文件内容:\n");
     int i, j, k;
-    char *data = new char[SectorSize];
+    char data[SectorSize];
     for (i = k = 0; i < numSectors; i++)
     {
-        if (i < NumDirect)
-            synchDisk->ReadSector(dataSectors[i], data);
-        else
-            synchDisk->ReadSector(indirect[i - NumDirect], data);
+        synchDisk->ReadSector(ByteToSector(i * SectorSize), data);
         for (j = 0; (j < SectorSize) && (k < numBytes); j++, k++)
             if ('\040' <= data[j] && data[j] <= '\176')
                 printf("%c", data[j]);
@@ -138,19 +246,13 @@ void FileHeader::Print()
 
 int FileHeader::ByteToSector(int offset)
 {
-    int sectorIndex = offset / SectorSize;
-    if (sectorIndex < NumDirect)
-        return dataSectors[sectorIndex];
-    else
-    {
-        int *indirect = this->GetIndirect();
-        return indirect[sectorIndex - NumDirect];
-    }
+    return *SectorSlot(offset / SectorSize, NULL);
 }
 
 void FileHeader::FetchFrom(int sectorNumber)
 {
     synchDisk->ReadSector(sectorNumber, (char *)this);
+    DropIndex(); // 缓存属于原来的文件头
 }
 
 void FileHeader::WriteBack(int sectorNumber)
@@ -175,27 +277,6 @@ long FileHeader::GetModTime()
     return modTime;
 }
 
-bool FileHeader::ifIndirect()
-{
-    return (this->numSectors() > NumDirect && indirectSector == 0);
-}
-
-// 获取二级索引
-int *FileHeader::GetIndirect()
-{
-    int *indirect = new int[NumIndirect];
-    synchDisk->ReadSector(indirectSector, (char *)indirect);
-    return indirect;
-}
-
-// 设置二级索引
-void FileHeader::SetIndirect(int *indirect)
-{
-    if (this->indirectSector == 0)
-        return;
-    synchDisk->WriteSector(indirectSector, (char *)indirect);
-}
-
 // 计算得到文件块数
 int FileHeader::numSectors()
 {
@@ -206,6 +287,14 @@ int FileHeader::numSectors()
 FileHeader::FileHeader()
 {
     memset(dataSectors, 0, sizeof(dataSectors));
-    indirectSector = 0;
+    memset(indexSectors, 0, sizeof(indexSectors));
+    memset(index, 0, sizeof(index));
+    numBytes = 0;
     modTime = 0;
-}
\ No newline at end of file
+}
+
+// 析构函数
+FileHeader::~FileHeader()
+{
+    DropIndex();
+}
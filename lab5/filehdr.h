@@ -1,4 +1,5 @@
 // 修改自filesys/filehdr.h
+// 除直接索引外，还有一级、二级和三级间接索引，文件可以与整个磁盘一样大
 
 #ifndef FILEHDR_H
 #define FILEHDR_H
@@ -6,15 +7,33 @@
 #include "disk.h"
 #include "bitmap.h"
 
-#define NumDirect (int)((SectorSize - 1 * sizeof(long) - 2 * sizeof(int)) / sizeof(int))
-#define NumIndirect (SectorSize / sizeof(int))
-#define MaxSectorNum (NumDirect + NumIndirect)
+#define NumLevels 3 // 间接索引的级数
+#define NumDirect (int)((SectorSize - 1 * sizeof(long) - (1 + NumLevels) * sizeof(int)) / sizeof(int))
+#define NumIndirect (int)(SectorSize / sizeof(int))
+#define MaxSectorNum (NumDirect + NumIndirect + NumIndirect * NumIndirect + \
+                      NumIndirect * NumIndirect * NumIndirect)
 #define MaxFileSize (MaxSectorNum * SectorSize)
 
+// 内存中的一个索引块。level 为 1 时 entries 是数据扇区，
+// 否则是下一级索引块的扇区，读入的下一级索引块放在 children 中
+class IndexBlock
+{
+public:
+  IndexBlock(int blockSector, int blockLevel, bool fresh); // fresh 为真时是新分配的块，不读磁盘
+  ~IndexBlock();                                 // 同时释放读入的下一级索引块
+
+  int sector;
+  int level;
+  bool dirty; // 是否比磁盘上的新
+  int entries[NumIndirect];
+  IndexBlock **children; // level 大于 1 时才有，未读入的为 NULL
+};
+
 class FileHeader
 {
 public:
   FileHeader(); // 构造函数初始化
+  ~FileHeader(); // 释放缓存的索引块
   bool Allocate(BitMap *bitMap, int fileSize);
   void Deallocate(BitMap *bitMap);
 
@@ -26,23 +45,31 @@ public:
   int FileLength();
 
   void Print();
-  bool ChangeFileSize(int newSize); // 更改文件大小
+  bool ChangeFileSize(BitMap *freeMap, int newSize); // 更改文件大小
   void SetModTime(long time);       // 设置修改时间
   long GetModTime();                // 获取修改时间
   int numSectors();                 // 计算得到文件块数
 
-  bool ifIndirect();     // 是否使用了两级索引
-  int *GetIndirect();              // 获取二级索引
-  void SetIndirect(int *indirect); // 设置二级索引
-
   //bool *GetPermission(); // 获取文件权限
 
 private:
   long modTime;
   int numBytes;
   int dataSectors[NumDirect];
-  int indirectSector;
+  int indexSectors[NumLevels]; // 一级、二级、三级索引的根，0 表示没有
  // int permission;
+
+  // 以下成员不在磁盘上（FetchFrom/WriteBack 只读写前 SectorSize 字节）
+  IndexBlock *index[NumLevels]; // 读入的索引树，文件头存在期间一直缓存
+
+  int *SectorSlot(int n, BitMap *freeMap); // 保存第 n 个数据扇区号的位置
+  IndexBlock *Root(int i, BitMap *freeMap);
+  IndexBlock *Child(IndexBlock *block, int i, BitMap *freeMap);
+  // 读入索引块；freeMap 不为 NULL 时分配还没有的索引块
+  void FlushIndex(IndexBlock *block);    // 写回修改过的索引块
+  void FreeIndex(IndexBlock *block, int count, BitMap *freeMap);
+  // 释放索引块下的前 count 个数据扇区和这些索引块
+  void DropIndex();                      // 丢弃缓存的索引树
 };
 
 #endif
@@ -1,9 +1,21 @@
 // filesys.cc
 // 实现了printinfo
+// 空闲扇区位图常驻内存：启动时读入一次，分配和回收只修改内存中的副本，
+// 在同步点（创建、删除文件，写回文件头之前）才写回磁盘。
+// 写回的顺序保证崩溃时最多丢失（泄漏）扇区，而不会出现
+// 文件头引用了位图中空闲的扇区：
+//   分配时先写位图，再写文件头和目录；
+//   回收时先写目录，再写位图。
+// 目录同样常驻内存，查找不访问磁盘；目录满时目录文件按倍数增长，
+// 新的部分和目录文件的文件头在加入新文件之前写回。
+// 目录项可以指向子目录，名称可以是从根目录开始的路径。
+// 子目录用时才读入；沿路径查找的结果（包括查找失败）记在
+// 路径缓存中，再次访问同一路径时不必读入中间的目录。
 
 #include "disk.h"
 #include "bitmap.h"
 #include "directory.h"
+#include "dentry.h"
 #include "filehdr.h"
 #include "filesys.h"
 
@@ -11,18 +23,15 @@
 #define DirectorySector 1
 
 #define FreeMapFileSize (NumSectors / BitsInByte)
-#define NumDirEntries 10
+#define NumDirEntries 10 // 新目录的初始大小，满了会自动增长
 #define DirectoryFileSize (sizeof(DirectoryEntry) * NumDirEntries)
+#define DentryCacheSize 64 // 路径缓存的项数
 
 
 // 输出文件系统信息
 void FileSystem::PrintInfo()
 {
-    BitMap *freeMap = new BitMap(NumSectors);
-    freeMap->FetchFrom(freeMapFile);
     int freeSectorsNum = freeMap->NumClear();
-    Directory *directory = new Directory(NumDirEntries);
-    directory->FetchFrom(directoryFile);
     int fileNum = directory->GetFileNum();
     int fileSize = directory->GetAllFileSize();
     int fileSectors = directory->GetAllFileSectors();
@@ -36,13 +45,24 @@ void FileSystem::PrintInfo()
     printf("内碎片字节数：%d\n", fileSectors * SectorSize - fileSize);
 }
 
+// 如果位图被修改过，写回磁盘
+void FileSystem::SyncFreeMap()
+{
+    if (!freeMapDirty)
+        return;
+    freeMap->WriteBack(freeMapFile);
+    freeMapDirty = FALSE;
+}
+
 FileSystem::FileSystem(bool format)
 {
     DEBUG('f', "正在初始化文件系统。\n");
+    freeMap = new BitMap(NumSectors);
+    freeMapDirty = FALSE;
+    dentries = new DentryCache(DentryCacheSize);
     if (format)
     {
-        BitMap *freeMap = new BitMap(NumSectors);            // 创建文件位图
-        Directory *directory = new Directory(NumDirEntries); // 创建包含10个文件目录项的文件目录表
+        directory = new Directory(NumDirEntries);            // 创建包含10个文件目录项的文件目录表
         FileHeader *mapHdr = new FileHeader;                 // 创建文件位图的文件头
         FileHeader *dirHdr = new FileHeader;                 // 创建文件目录的文件头
         DEBUG('f', "正在格式化文件系统。\n");
@@ -76,8 +96,6 @@ FileSystem::FileSystem(bool format)
             freeMap->Print();
             directory->Print();
         }
-        delete freeMap;
-        delete directory;
         delete mapHdr;
         delete dirHdr;
     }
@@ -87,118 +105,257 @@ FileSystem::FileSystem(bool format)
         // 位图和目录的文件；这些文件在Nachos运行时保持打开
         freeMapFile = new OpenFile(FreeMapSector);
         directoryFile = new OpenFile(DirectorySector);
+        freeMap->FetchFrom(freeMapFile); // 以后只使用内存中的副本
+        directory = new Directory(NumDirEntries);
+        directory->FetchFrom(directoryFile);
+    }
+}
+
+// 读入文件头在 sector 中的目录。根目录直接使用内存中的副本
+Directory *FileSystem::FetchDirectory(int sector, OpenFile **file)
+{
+    Directory *dir;
+
+    if (sector == DirectorySector)
+    {
+        *file = directoryFile;
+        return directory;
+    }
+    *file = new OpenFile(sector);
+    dir = new Directory(0);
+    dir->FetchFrom(*file);
+    return dir;
+}
+
+void FileSystem::ReleaseDirectory(Directory *dir, OpenFile *file)
+{
+    if (dir == directory)
+        return;
+    delete dir;
+    delete file;
+}
+
+int FileSystem::LookupEntry(int dirSector, char *name, bool *isDir)
+{
+    Directory *dir;
+    OpenFile *dirFile;
+    int sector;
+
+    if (dentries->Lookup(dirSector, name, &sector, isDir))
+        return sector;
+    dir = FetchDirectory(dirSector, &dirFile);
+    sector = dir->Find(name);
+    *isDir = dir->IsDirectory(name);
+    ReleaseDirectory(dir, dirFile);
+    dentries->Enter(dirSector, name, sector, *isDir); // sector 为 -1 时是否定项
+    return sector;
+}
+
+// 路径中多余的 '/' 被忽略；每一级名称与目录中一样只看前 FileNameMaxLen 个字符。
+// 中间某一级不存在或不是目录时返回 -1
+int FileSystem::LookupParent(char *path, char *leaf)
+{
+    int dirSector = DirectorySector;
+    bool isDir;
+    char *p = path;
+    int len;
+
+    while (*p == '/')
+        p++;
+    if (*p == '\0')
+        return -1; // 空路径或根目录本身
+    for (;;)
+    {
+        len = strcspn(p, "/");
+        memset(leaf, 0, FileNameMaxLen + 1);
+        strncpy(leaf, p, min(len, FileNameMaxLen));
+        for (p += len; *p == '/'; p++)
+            ;
+        if (*p == '\0')
+            return dirSector;
+        dirSector = LookupEntry(dirSector, leaf, &isDir);
+        if (dirSector == -1 || !isDir)
+            return -1;
     }
 }
 
 bool FileSystem::Create(char *name, int initialSize)
 {
-    Directory *directory;
-    BitMap *freeMap;
+    return CreateEntry(name, initialSize, FALSE);
+}
+
+bool FileSystem::MkDir(char *name)
+{
+    return CreateEntry(name, DirectoryFileSize, TRUE);
+}
+
+bool FileSystem::CreateEntry(char *name, int initialSize, bool isDir)
+{
+    Directory *dir;
+    OpenFile *dirFile;
     FileHeader *hdr;
-    int sector;
+    char leaf[FileNameMaxLen + 1];
+    int parent, sector;
     bool success;
 
-    DEBUG('f', "正在创建文件 %s, 大小 %d\n", name, initialSize);
-
-    directory = new Directory(NumDirEntries);
-    directory->FetchFrom(directoryFile);
+    DEBUG('f', "正在创建%s %s, 大小 %d\n", isDir ? "目录" : "文件", name, initialSize);
 
-    if (directory->Find(name) != -1)
+    parent = LookupParent(name, leaf);
+    if (parent == -1)
+        return FALSE; // 路径中的目录不存在
+    dir = FetchDirectory(parent, &dirFile);
+    if (dir->Find(leaf) != -1)
         success = FALSE; // 文件已在目录中
     else
     {
-        freeMap = new BitMap(NumSectors);
-        freeMap->FetchFrom(freeMapFile);
+        if (dir->IsFull() && dir->Grow(dirFile))
+            dirFile->WriteBack(); // 目录文件变长了，写回位图和它的文件头
         sector = freeMap->Find(); // 找到一个扇区来保存文件头
         if (sector == -1)
             success = FALSE; // 没有可用的文件头块
-        else if (!directory->Add(name, sector))
+        else if (!dir->Add(leaf, sector, isDir))
+        {
+            freeMap->Clear(sector);
             success = FALSE; // 目录中没有空间
+        }
         else
         {
             hdr = new FileHeader;
             if (!hdr->Allocate(freeMap, initialSize))
+            {
+                freeMap->Clear(sector);
+                dir->Remove(leaf); // 目录项还没有写回
                 success = FALSE; // 磁盘上没有空间用于数据
+            }
             else
             {
                 success = TRUE;
-                // 一切正常，将所有更改刷新回磁盘
+                // 一切正常，将所有更改刷新回磁盘，位图在前
+                freeMapDirty = TRUE;
+                SyncFreeMap();
                 hdr->WriteBack(sector);
-                directory->WriteBack(directoryFile);
-                freeMap->WriteBack(freeMapFile);
+                if (isDir)
+                { // 新目录的内容在父目录引用它之前写回
+                    OpenFile *subFile = new OpenFile(sector);
+                    Directory *sub = new Directory(NumDirEntries);
+                    sub->WriteBack(subFile);
+                    delete sub;
+                    delete subFile;
+                }
+                dir->WriteBack(dirFile);
+                dentries->Enter(parent, leaf, sector, isDir);
             }
             delete hdr;
         }
-        delete freeMap;
     }
-    delete directory;
+    ReleaseDirectory(dir, dirFile);
     return success;
 }
 
 OpenFile *
 FileSystem::Open(char *name)
 {
-    Directory *directory = new Directory(NumDirEntries);
     OpenFile *openFile = NULL;
-    int sector;
+    char leaf[FileNameMaxLen + 1];
+    int parent, sector;
+    bool isDir;
 
     DEBUG('f', "正在打开文件 %s\n", name);
-    directory->FetchFrom(directoryFile);
-    sector = directory->Find(name);
-    if (sector >= 0)
+    parent = LookupParent(name, leaf);
+    if (parent == -1)
+        return NULL;
+    sector = LookupEntry(parent, leaf, &isDir);
+    if (sector >= 0 && !isDir)
         openFile = new OpenFile(sector); // 在目录中找到了名称
-    delete directory;
     return openFile; // 如果未找到则返回NULL
 }
 
 bool FileSystem::Remove(char *name)
 {
-    Directory *directory;
-    BitMap *freeMap;
+    return RemoveEntry(name, FALSE);
+}
+
+bool FileSystem::RmDir(char *name)
+{
+    return RemoveEntry(name, TRUE);
+}
+
+bool FileSystem::RemoveEntry(char *name, bool isDir)
+{
+    Directory *dir, *sub;
+    OpenFile *dirFile, *subFile;
     FileHeader *fileHdr;
-    int sector;
+    char leaf[FileNameMaxLen + 1];
+    int parent, sector;
+    bool empty;
 
-    directory = new Directory(NumDirEntries);
-    directory->FetchFrom(directoryFile);
-    sector = directory->Find(name);
-    if (sector == -1)
+    parent = LookupParent(name, leaf);
+    if (parent == -1)
+        return FALSE; // 路径中的目录不存在
+    dir = FetchDirectory(parent, &dirFile);
+    sector = dir->Find(leaf);
+    if (sector == -1 || dir->IsDirectory(leaf) != isDir)
     {
-        delete directory;
-        return FALSE; // 文件未找到
+        ReleaseDirectory(dir, dirFile);
+        return FALSE; // 文件未找到，或者类型不对
+    }
+    if (isDir)
+    {
+        sub = FetchDirectory(sector, &subFile);
+        empty = sub->IsEmpty();
+        ReleaseDirectory(sub, subFile);
+        if (!empty)
+        {
+            ReleaseDirectory(dir, dirFile);
+            return FALSE; // 只能删除空目录
+        }
     }
     fileHdr = new FileHeader;
     fileHdr->FetchFrom(sector);
 
-    freeMap = new BitMap(NumSectors);
-    freeMap->FetchFrom(freeMapFile);
-
     fileHdr->Deallocate(freeMap); // 删除数据块
     freeMap->Clear(sector);       // 删除头部块
-    directory->Remove(name);
+    freeMapDirty = TRUE;
+    dir->Remove(leaf);
 
-    freeMap->WriteBack(freeMapFile);     // 刷新到磁盘
-    directory->WriteBack(directoryFile); // 刷新到磁盘
+    dir->WriteBack(dirFile); // 刷新到磁盘，目录在前
+    SyncFreeMap();
+    dentries->Enter(parent, leaf, -1, FALSE);
+    if (isDir)
+        dentries->Purge(sector); // 扇区可能被重新使用
+    ReleaseDirectory(dir, dirFile);
     delete fileHdr;
-    delete directory;
-    delete freeMap;
     return TRUE;
 }
 
-void FileSystem::List()
+void FileSystem::List(char *name)
 {
-    Directory *directory = new Directory(NumDirEntries);
+    Directory *dir;
+    OpenFile *dirFile;
+    char leaf[FileNameMaxLen + 1];
+    int parent, sector;
+    bool isDir;
 
-    directory->FetchFrom(directoryFile);
-    directory->List();
-    delete directory;
+    if (name == NULL || name[strspn(name, "/")] == '\0')
+    {
+        directory->List();
+        return;
+    }
+    parent = LookupParent(name, leaf);
+    sector = parent == -1 ? -1 : LookupEntry(parent, leaf, &isDir);
+    if (sector == -1 || !isDir)
+    {
+        printf("目录 %s 不存在\n", name);
+        return;
+    }
+    dir = FetchDirectory(sector, &dirFile);
+    dir->List();
+    ReleaseDirectory(dir, dirFile);
 }
-
 void FileSystem::Print()
 {
     FileHeader *bitHdr = new FileHeader;
     FileHeader *dirHdr = new FileHeader;
-    BitMap *freeMap = new BitMap(NumSectors);
-    Directory *directory = new Directory(NumDirEntries);
 
     printf("位图文件头:\n");
     bitHdr->FetchFrom(FreeMapSector);
@@ -208,14 +365,10 @@ void FileSystem::Print()
     dirHdr->FetchFrom(DirectorySector);
     dirHdr->Print();
 
-    freeMap->FetchFrom(freeMapFile);
     freeMap->Print();
 
-    directory->FetchFrom(directoryFile);
     directory->Print();
 
     delete bitHdr;
     delete dirHdr;
-    delete freeMap;
-    delete directory;
 }
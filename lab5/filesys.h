@@ -13,6 +13,7 @@
 //
 //	在“真实”实现中，文件系统中使用了两个关键数据结构。
 //	有一个单一的“根”目录，列出文件系统中的所有文件；与UNIX不同，基线系统不提供分层目录结构。
+//	（lab5 中目录项可以指向子目录，文件名可以是从根目录开始的路径。）
 //	此外，还有一个位图用于分配磁盘扇区。根目录和位图本身都作为文件存储在Nachos文件系统中——这在模拟磁盘初始化时造成了一个有趣的引导问题。
 //
 
@@ -52,6 +53,10 @@ public:
 };
 
 #else // FILESYS
+class BitMap;
+class Directory;
+class DentryCache;
+
 class FileSystem
 {
 public:
@@ -60,6 +65,8 @@ public:
                            // 如果“format”，磁盘上没有任何内容，
                            // 因此初始化目录和空闲块的位图。
 
+  // 以下的名称都可以是路径，如 "/a/b/c" 或 "a/b"，都从根目录开始查找
+
   bool Create(char *name, int initialSize);
   // 创建一个文件（UNIX creat）
 
@@ -67,17 +74,42 @@ public:
 
   bool Remove(char *name); // 删除一个文件（UNIX unlink）
 
-  void List(); // 列出文件系统中的所有文件
+  bool MkDir(char *name); // 创建一个子目录（UNIX mkdir）
+
+  bool RmDir(char *name); // 删除一个空的子目录（UNIX rmdir）
+
+  void List(char *name = NULL); // 列出一个目录中的所有文件，默认为根目录
 
   void Print(); // 列出所有文件及其内容
 
   void PrintInfo(); // 打印文件系统信息
 
+  BitMap *FreeMap() { return freeMap; } // 常驻内存的空闲扇区位图
+  void FreeMapChanged() { freeMapDirty = TRUE; } // 修改位图后调用
+  void SyncFreeMap(); // 如果位图被修改过，写回磁盘。
+                      // 在写回引用新分配扇区的文件头之前调用
+
 private:
   OpenFile *freeMapFile; // 空闲磁盘块的位图，
                          // 作为文件表示
+  BitMap *freeMap;       // 位图在内存中的副本，启动时读入一次
+  bool freeMapDirty;     // 副本是否比磁盘上的新
   OpenFile *directoryFile; // “根”目录——文件名列表，
                            // 作为文件表示
+  Directory *directory;    // 目录在内存中的副本，启动时读入一次，
+                           // 修改后只写回改动的目录项
+  DentryCache *dentries;   // 路径查找的缓存
+
+  bool CreateEntry(char *name, int initialSize, bool isDir);
+  bool RemoveEntry(char *name, bool isDir);
+  int LookupEntry(int dirSector, char *name, bool *isDir);
+  // 在一个目录中查找 name，先查缓存
+  int LookupParent(char *path, char *leaf);
+  // 查找路径的最后一级所在的目录，返回它的文件头扇区，
+  // 最后一级的名称复制到 leaf 中
+  Directory *FetchDirectory(int sector, OpenFile **file);
+  void ReleaseDirectory(Directory *dir, OpenFile *file);
+  // 根目录常驻内存，子目录用时读入
 };
 
 #endif // FILESYS
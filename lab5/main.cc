@@ -10,8 +10,10 @@
 //
 // 用法: nachos -d <调试标志> -rs <随机种子 #>
 //		-s -x <nachos 文件> -c <控制台输入> <控制台输出>
-//		-f -cp <unix 文件> <nachos 文件>
-//		-p <nachos 文件> -r <nachos 文件> -l -D -t
+//		-f -bc <缓存扇区数> -ds <调度策略> -dm <写回策略>
+//		-dg <轨道数> <每轨扇区数> -cp <unix 文件> <nachos 文件>
+//		-p <nachos 文件> -r <nachos 文件> -l [<nachos 目录>] -D -t
+//		-mkdir <nachos 目录> -rmdir <nachos 目录>
 //              -n <网络可靠性> -m <机器 ID>
 //              -o <其他机器 ID>
 //              -z
@@ -26,12 +28,19 @@
 //
 //  文件系统
 //    -f 会导致物理磁盘被格式化
+//    -bc 在磁盘之上使用写回的扇区缓存，命令执行完后写回
+//    -ds 磁盘请求的调度策略：fcfs、sstf、scan 或 clook
+//    -dm 把磁盘映像映射到内存，写回策略为 none、halt 或 periodic
+//    -dg 按给定的几何参数重新创建磁盘（隐含 -f）
 //    -cp 从 UNIX 复制文件到 Nachos
 //    -p 打印一个 Nachos 文件到标准输出
 //    -r 从文件系统中删除 Nachos 文件
-//    -l 列出 Nachos 目录的内容
+//    -l 列出 Nachos 目录的内容，默认为根目录
+//    -mkdir 创建一个 Nachos 目录
+//    -rmdir 删除一个空的 Nachos 目录
 //    -D 打印整个文件系统的内容
 //    -t 测试 Nachos 文件系统的性能
+//    Nachos 文件和目录的名称可以是路径，如 /a/b/c
 //
 //  网络
 //    -n 设置网络可靠性
@@ -143,7 +152,27 @@ int main(int argc, char **argv)
 		}
 		else if (!strcmp(*argv, "-l"))
 		{ // 列出 Nachos 目录
-			fileSystem->List();
+			if (argc > 1 && **(argv + 1) != '-')
+			{
+				fileSystem->List(*(argv + 1));
+				argCount = 2;
+			}
+			else
+				fileSystem->List();
+		}
+		else if (!strcmp(*argv, "-mkdir"))
+		{ // 创建 Nachos 目录
+			ASSERT(argc > 1);
+			if (!fileSystem->MkDir(*(argv + 1)))
+				printf("无法创建目录 %s\n", *(argv + 1));
+			argCount = 2;
+		}
+		else if (!strcmp(*argv, "-rmdir"))
+		{ // 删除 Nachos 目录
+			ASSERT(argc > 1);
+			if (!fileSystem->RmDir(*(argv + 1)))
+				printf("无法删除目录 %s\n", *(argv + 1));
+			argCount = 2;
 		}
 		else if (!strcmp(*argv, "-D"))
 		{ // 打印整个文件系统
@@ -169,6 +198,10 @@ int main(int argc, char **argv)
 #endif // NETWORK
 	}
 
+#ifdef FILESYS
+	synchDisk->Flush(); // 把扇区缓存写回磁盘
+#endif
+
 	currentThread->Finish(); // 注意: 如果过程 "main"
 							 // 返回，则程序 "nachos"
 							 // 将退出（就像任何其他正常程序
@@ -7,6 +7,7 @@
 
 void OpenFile::WriteBack()
 {
+    fileSystem->SyncFreeMap();          // 先写回位图，文件头才能引用新分配的扇区
     hdr->WriteBack(this->sectorNumber); // 写回文件头扇区
     this->changed = false;
 }
@@ -17,6 +18,7 @@ OpenFile::OpenFile(int sector)
     hdr = new FileHeader();
     hdr->FetchFrom(sector);
     seekPosition = 0;
+    changed = false;
 }
 
 OpenFile::~OpenFile()
@@ -46,11 +48,13 @@ int OpenFile::Write(char *into, int numBytes)
     return result;
 }
 
+// 部分扇区经过一个扇区大小的缓冲区；完整扇区直接读入/写出调用者的缓冲区，
+// 磁盘上连续的完整扇区合并为一次多扇区请求
 int OpenFile::ReadAt(char *into, int numBytes, int position)
 {
     int fileLength = hdr->FileLength();
-    int i, firstSector, lastSector, numSectors;
-    char *buf;
+    int offset, end, inSector, chunk, sector, count;
+    char buf[SectorSize];
 
     if ((numBytes <= 0) || (position > fileLength))
         return 0;
@@ -61,68 +65,85 @@ int OpenFile::ReadAt(char *into, int numBytes, int position)
     DEBUG('f', "正在读取 %d 字节，位置 %d，文件长度 %d.\n",
           numBytes, position, fileLength);
 
-    firstSector = divRoundDown(position, SectorSize);
-    lastSector = divRoundDown(position + numBytes - 1, SectorSize);
-    numSectors = 1 + lastSector - firstSector;
-
-    buf = new char[numSectors * SectorSize];
-    for (i = firstSector; i <= lastSector; i++)
-        synchDisk->ReadSector(hdr->ByteToSector(i*SectorSize),
-                              &buf[(i - firstSector) * SectorSize]);
-
-    bcopy(&buf[position - (firstSector * SectorSize)], into, numBytes);
-    delete[] buf;
+    end = position + numBytes;
+    for (offset = position; offset < end; offset += chunk)
+    {
+        inSector = offset % SectorSize;
+        sector = hdr->ByteToSector(offset);
+        if (inSector != 0 || end - offset < SectorSize)
+        { // 部分扇区
+            chunk = min(SectorSize - inSector, end - offset);
+            synchDisk->ReadSector(sector, buf);
+            bcopy(&buf[inSector], &into[offset - position], chunk);
+        }
+        else
+        { // 连续的完整扇区
+            count = ContiguousSectors(offset, end, sector);
+            chunk = count * SectorSize;
+            synchDisk->ReadSectors(sector, count, &into[offset - position]);
+        }
+    }
     return numBytes;
 }
 
 int OpenFile::WriteAt(char *from, int numBytes, int position)
 {
     int fileLength = hdr->FileLength();
-    int i, firstSector, lastSector, numSectors;
-    bool firstAligned, lastAligned;
-    char *buf;
+    int offset, end, inSector, chunk, sector, count;
+    char buf[SectorSize];
 
     if ((numBytes <= 0) || (position > fileLength))
         return 0;
     if ((position + numBytes) > fileLength)
-        if (!hdr->ChangeFileSize(position + numBytes))
+        if (!hdr->ChangeFileSize(fileSystem->FreeMap(), position + numBytes))
         // 修改文件大小
         {
             numBytes = fileLength - position;
         }
         else
         {
+            fileSystem->FreeMapChanged(); // 位图在文件头写回时才写回
             this->changed = true;
         }
 
     DEBUG('f', "正在写入 %d 字节，位置 %d，文件长度 %d.\n",
           numBytes, position, fileLength);
 
-    firstSector = divRoundDown(position, SectorSize);
-    lastSector = divRoundDown(position + numBytes - 1, SectorSize);
-    numSectors = 1 + lastSector - firstSector;
-
-    buf = new char[numSectors * SectorSize];
-
-    firstAligned = (bool)(position == (firstSector * SectorSize));
-    lastAligned = (bool)((position + numBytes) == ((lastSector + 1) * SectorSize));
-
-    if (!firstAligned)
-        ReadAt(buf, SectorSize, firstSector * SectorSize);
-    if (!lastAligned && ((firstSector != lastSector) || firstAligned))
-        ReadAt(&buf[(lastSector - firstSector) * SectorSize],
-               SectorSize, lastSector * SectorSize);
-
-    bcopy(from, &buf[position - (firstSector * SectorSize)], numBytes);
-
-    for (i = firstSector; i <= lastSector; i++)
-        synchDisk->WriteSector(hdr->ByteToSector(i*SectorSize),
-                               &buf[(i - firstSector) * SectorSize]);
-    delete[] buf;
+    end = position + numBytes;
+    for (offset = position; offset < end; offset += chunk)
+    {
+        inSector = offset % SectorSize;
+        sector = hdr->ByteToSector(offset);
+        if (inSector != 0 || end - offset < SectorSize)
+        { // 部分扇区：先读出，修改后写回
+            chunk = min(SectorSize - inSector, end - offset);
+            synchDisk->ReadSector(sector, buf);
+            bcopy(&from[offset - position], &buf[inSector], chunk);
+            synchDisk->WriteSector(sector, buf);
+        }
+        else
+        { // 连续的完整扇区
+            count = ContiguousSectors(offset, end, sector);
+            chunk = count * SectorSize;
+            synchDisk->WriteSectors(sector, count, &from[offset - position]);
+        }
+    }
     SetModTime(time(NULL)); // 设置修改时间
     return numBytes;
 }
 
+// 从扇区对齐的offset开始（位于磁盘扇区sector），[offset, end)中
+// 有多少个完整扇区在磁盘上也是连续的，至少为1
+int OpenFile::ContiguousSectors(int offset, int end, int sector)
+{
+    int count = 1;
+
+    while (offset + (count + 1) * SectorSize <= end &&
+           hdr->ByteToSector(offset + count * SectorSize) == sector + count)
+        count++;
+    return count;
+}
+
 int OpenFile::Length()
 {
     return hdr->FileLength();
@@ -30,6 +30,8 @@ private:
   int seekPosition;
   int sectorNumber;
   bool changed;
+
+  int ContiguousSectors(int offset, int end, int sector); // 从offset起在磁盘上连续的完整扇区数
 };
 
 #endif
@@ -104,6 +104,8 @@ AddrSpace::~AddrSpace()
     {
         freePhys_Map->Clear(pageTable[i].physicalPage);
     }
+    if (machine->tlb != NULL)
+        machine->tlb->FlushASID(spaceId); // TLB项指向这个页表
     delete[] pageTable;
 }
 
@@ -136,4 +138,5 @@ void AddrSpace::RestoreState()
 {
     machine->pageTable = pageTable;
     machine->pageTableSize = numPages;
+    machine->asid = spaceId; // TLB项以地址空间标识为标记，切换时无需清空
 }
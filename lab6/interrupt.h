@@ -6,6 +6,7 @@
 #define INTERRUPT_H
 
 #include "list.h"
+#include "eventqueue.h"
 
 enum IntStatus
 {
@@ -30,6 +31,8 @@ enum IntType
   NetworkRecvInt
 };
 
+#define NoPendingTime 0x7fffffff // 没有待处理的中断时 nextDue 的值
+
 class PendingInterrupt
 {
 public:
@@ -40,6 +43,7 @@ public:
   _int arg;                // 函数的参数。
   int when;                // 中断应该触发的时间
   IntType type;            // 用于调试
+  PendingInterrupt *next;  // 触发后放入空闲链表，供以后的中断重用
 };
 
 // 以下类定义了硬件中断模拟的数据结构。
@@ -80,14 +84,18 @@ public:
                 int fromnow, IntType type);        // “fromNow”是中断将在未来（在模拟时间中）发生的时间。
                                                    // 这是由硬件设备模拟器调用的。
 
-  void OneTick(); // 推进模拟时间
+  void OneTick(int count = 1); // 推进模拟时间（"count"个时钟）
+  int TicksUntilDue();         // 距离下一个待处理中断到期的时钟数
 
 private:
   IntStatus level;      // 中断是否被启用或禁用？
-  List *pending;        // 计划在未来发生的中断列表
+  EventQueue *pending;  // 计划在未来发生的中断，按 (时间, 调度先后) 排序
+  PendingInterrupt *freeList; // 已触发的中断节点，Schedule 时重用
   bool inHandler;       // 如果我们正在运行中断处理程序则为TRUE
   bool yieldOnReturn;   // 如果我们在从中断处理程序返回时要进行上下文切换则为TRUE
   MachineStatus status; // 空闲，内核模式，用户模式
+  int nextDue;          // 最早的待处理中断的时间（缓存）
+  bool traceTicks;      // 是否打印每个时钟（-d i）
 
   // 这些函数是中断模拟代码的内部内容
 
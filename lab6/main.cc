@@ -9,7 +9,7 @@
 // 	此文件的大部分内容在后续作业中不需要。
 //
 // 用法: nachos -d <调试标志> -rs <随机种子 #>
-//		-s -x <nachos 文件> -c <控制台输入> <控制台输出>
+//		-s -bb -dump <文件> -tlb <条目数> <相联度> <策略> -x <nachos 文件> -c <控制台输入> <控制台输出>
 //		-f -cp <unix 文件> <nachos 文件>
 //		-p <nachos 文件> -r <nachos 文件> -l -D -t
 //              -n <网络可靠性> -e <网络可达性>
@@ -22,6 +22,9 @@
 //
 //  用户程序
 //    -s 会导致用户程序以单步模式执行
+//    -bb 以基本块翻译模式执行用户程序（单步调试时无效）
+//    -dump 停机时把寄存器、用户时钟和主存写到文件，用于比较 -bb 与解释执行
+//    -tlb 使用带地址空间标识的组相联 TLB，策略为 lru、fifo 或 random
 //    -x 运行一个用户程序
 //    -c 测试控制台
 //
@@ -75,6 +75,11 @@ void Initialize(int argc, char **argv)
 
 #ifdef USER_PROGRAM
   bool debugUserProg = FALSE; // 单步调试用户程序
+  bool translateUserProg = FALSE; // 以基本块翻译模式执行用户程序
+  char *stateFile = NULL;         // 停机时写出机器状态的文件
+  int tlbEntries = 0;             // TLB 条目数，0 表示使用编译时的设置
+  int tlbWays = 0;                // TLB 相联度
+  TLBPolicy tlbPolicy = TLBLRU;   // TLB 替换策略
 #endif
 #ifdef FILESYS_NEEDED
   bool format = FALSE; // 格式化磁盘
@@ -109,6 +114,27 @@ void Initialize(int argc, char **argv)
 #ifdef USER_PROGRAM
     if (!strcmp(*argv, "-s"))
       debugUserProg = TRUE;
+    else if (!strcmp(*argv, "-bb"))
+      translateUserProg = TRUE;
+    else if (!strcmp(*argv, "-dump"))
+    {
+      ASSERT(argc > 1);
+      stateFile = *(argv + 1);
+      argCount = 2;
+    }
+    else if (!strcmp(*argv, "-tlb"))
+    {
+      ASSERT(argc > 3);
+      tlbEntries = atoi(*(argv + 1));
+      tlbWays = atoi(*(argv + 2));
+      if (!strcmp(*(argv + 3), "fifo"))
+        tlbPolicy = TLBFIFO;
+      else if (!strcmp(*(argv + 3), "random"))
+        tlbPolicy = TLBRandom;
+      else
+        ASSERT(!strcmp(*(argv + 3), "lru"));
+      argCount = 4;
+    }
 #endif
 #ifdef FILESYS_NEEDED
     if (!strcmp(*argv, "-f"))
@@ -155,7 +181,10 @@ void Initialize(int argc, char **argv)
   CallOnUserAbort(Cleanup); // 如果用户按下 ctl-C
 
 #ifdef USER_PROGRAM
-  machine = new Machine(debugUserProg); // 这必须先执行
+  machine = new Machine(debugUserProg, translateUserProg); // 这必须先执行
+  if (tlbEntries > 0)
+    machine->UseTLB(tlbEntries, tlbWays, tlbPolicy);
+  machine->stateFile = stateFile;
   freePhys_Map = new BitMap(NumPhysPages);
   space = 0;
 #endif
@@ -1,81 +1,272 @@
 // addrSpace.cc 修改自 lab6/addrspace.cc
-// 创建交换文件方法
-// 找到需要换出的页FIFO
+// 页换出到交换设备（见 swapdev.h）
+// 找到需要换出的页：FIFO、时钟、增强型二次机会、近似 LRU 或随机
+// 全局置换时按缺页频率调整帧数上限，帧从共享的帧表中取得
+// 交换区按需使用：页第一次进入内存时从可执行文件读入或填零，
+// 只有被修改过的页换出时才分配交换槽
 
 #include "system.h"
 #include "addrspace.h"
-#include "noff.h"
 
 void AddrSpace::WriteToSwap(int outPage)
 {
     if (pageTable[outPage].dirty)
     {
-        swapFile->WriteAt(&(machine->mainMemory[pageTable[outPage].physicalPage * PageSize]),
-                          PageSize, outPage * PageSize);
+        if (swapSlot[outPage] < 0)
+            swapSlot[outPage] = swapDevice->Allocate();
+        if (swapSlot[outPage] < 0)
+        {
+            printf("交换区已满\n");
+            currentThread->Finish();
+        }
+        swapDevice->WritePage(swapSlot[outPage],
+                              &(machine->mainMemory[pageTable[outPage].physicalPage * PageSize]));
         stats->numPageWrites++;
-        printf("将页 %d 写入交换文件\n", outPage);
+        stats->policyPageWrites[replacePolicy]++;
+        printf("将页 %d 写入交换槽 %d\n", outPage, swapSlot[outPage]);
     }
     else
     {
-        printf("此页没有被修改，不需要写入交换文件\n");
+        printf("此页没有被修改，不需要写入交换区\n");
     }
 }
 
 int AddrSpace::FindPageOut()
 {
+    if (numResident < frameLimit)
+        return -1; // 驻留页数未达到帧数上限，可以再分配一帧
+    switch (replacePolicy)
+    {
+    case ReplaceClock:
+        return FindClock();
+    case ReplaceEnhanced:
+        return FindEnhanced();
+    case ReplaceLRU:
+        return FindLRU();
+    case ReplaceRandom:
+        idx = Random() % numResident;
+        return pageInMem[idx];
+    default:
+        return pageInMem[idx]; // FIFO：idx 指向最先进入内存的页
+    }
+}
+
+// 跳过 use 位为真的页并清除它们的 use 位
+int AddrSpace::FindClock()
+{
+    while (pageTable[pageInMem[idx]].use)
+    {
+        pageTable[pageInMem[idx]].use = FALSE;
+        idx = (idx + 1) % numResident;
+    }
+    return pageInMem[idx];
+}
+
+// 先找 (use, dirty) 为 (0, 0) 的页，不改变 use 位；
+// 再找 (0, 1) 的页，同时清除经过的页的 use 位。最多两轮
+int AddrSpace::FindEnhanced()
+{
+    int n;
+
+    for (;;)
+    {
+        for (n = 0; n < numResident; n++, idx = (idx + 1) % numResident)
+            if (!pageTable[pageInMem[idx]].use && !pageTable[pageInMem[idx]].dirty)
+                return pageInMem[idx];
+        for (n = 0; n < numResident; n++, idx = (idx + 1) % numResident)
+        {
+            if (!pageTable[pageInMem[idx]].use)
+                return pageInMem[idx];
+            pageTable[pageInMem[idx]].use = FALSE;
+        }
+    }
+}
+
+// 换出老化计数器最小的页
+int AddrSpace::FindLRU()
+{
+    for (int i = 0; i < numResident; i++)
+        if (age[pageInMem[i]] < age[pageInMem[idx]])
+            idx = i;
     return pageInMem[idx];
 }
 
+// 在每次页错误时调用，计数器的高位是最近的 use 位
+void AddrSpace::AgePages()
+{
+    for (int i = 0; i < numResident; i++)
+    {
+        int page = pageInMem[i];
+        age[page] = (age[page] >> 1) | (pageTable[page].use ? 0x80000000 : 0);
+        pageTable[page].use = FALSE;
+    }
+}
+
+// 把页放在 idx 之前，即最新进入内存的位置。驻留页达到上限时 idx 回到开头
+void AddrSpace::InsertResident(int page)
+{
+    for (int i = numResident; i > idx; i--)
+        pageInMem[i] = pageInMem[i - 1];
+    pageInMem[idx++] = page;
+    numResident++;
+    if (idx >= numResident && numResident >= frameLimit)
+        idx = 0;
+}
+
+// 从驻留页中去掉一页，其余页的先后顺序不变
+void AddrSpace::RemoveResident(int page)
+{
+    int slot = 0;
+
+    while (pageInMem[slot] != page)
+    {
+        slot++;
+        ASSERT(slot < numResident);
+    }
+    numResident--;
+    for (int i = slot; i < numResident; i++)
+        pageInMem[i] = pageInMem[i + 1];
+    if (slot < idx)
+        idx--;
+    if (idx > numResident || (idx == numResident && numResident >= frameLimit))
+        idx = 0;
+}
+// 缺页频率控制。距上次页错误不到 PFFInterval 个用户时钟周期时，
+// 驻留集小于工作集，帧数上限加一；否则上次页错误以来没有访问过的页
+// 已离开工作集，把它们换出并把帧还给帧表
+void AddrSpace::AdjustResidentSet()
+{
+    int interval = stats->userTicks - lastFaultTick;
+    int released = 0;
+
+    lastFaultTick = stats->userTicks;
+    if (interval < PFFInterval)
+    {
+        if (frameLimit < (int)numPages)
+        {
+            frameLimit++;
+            stats->numResidentGrows++;
+        }
+        return;
+    }
+    for (int i = numResident - 1; i >= 0; i--)
+    {
+        int page = pageInMem[i];
+        int frame = pageTable[page].physicalPage;
+        if (pageTable[page].use)
+            continue;
+        EvictPage(page);
+        frameTable->Release(frame);
+        released++;
+    }
+    if (numResident + 1 < frameLimit)
+        stats->numResidentShrinks++;
+    frameLimit = numResident + 1; // 留一帧给这次页错误
+    if (released > 0)
+    {
+        stats->numFramesReleased += released;
+        printf("地址空间 %d 的工作集缩小，释放 %d 帧\n", spaceId, released);
+    }
+}
+
+// 把驻留页写回交换区并置为无效，它的帧由调用者处理
+void AddrSpace::EvictPage(int page)
+{
+    stats->policyPageOuts[replacePolicy]++;
+    WriteToSwap(page);
+    pageTable[page].physicalPage = -1;
+    pageTable[page].valid = FALSE;
+    RemoveResident(page);
+    printf("将页 %d 换出到交换区\n", page);
+}
+
+// 帧表从这个地址空间取走一帧。被其他进程取走时，帧数上限降为剩下的驻留页数
+void AddrSpace::StealPage(int page, bool shrink)
+{
+    EvictPage(page);
+    if (shrink && frameLimit > numResident)
+    {
+        frameLimit = numResident > 0 ? numResident : 1;
+        if (idx >= numResident)
+            idx = 0;
+    }
+}
+
 void AddrSpace::GetPageToMem(int needPage)
 {
     stats->numPageFaults++;
+    stats->policyFaults[replacePolicy]++;
+    if (frameTable != NULL)
+        AdjustResidentSet(); // 要在老化清除 use 位之前
+    if (replacePolicy == ReplaceLRU || frameTable != NULL)
+        AgePages();
     int outPage = FindPageOut();
     if (outPage < 0)
     {
         printf("此时内存还未达到最大帧数，所以可以分配一个物理页");
-        pageTable[needPage].physicalPage = freePhys_Map->Find();
+        if (frameTable != NULL)
+            pageTable[needPage].physicalPage = frameTable->Allocate(this, needPage);
+        else
+            pageTable[needPage].physicalPage = freePhys_Map->Find();
         printf("将页 %d 分配到物理页 %d\n", needPage, pageTable[needPage].physicalPage);
+        InsertResident(needPage);
     }
     else
     {
+        stats->policyPageOuts[replacePolicy]++;
         WriteToSwap(outPage);
         pageTable[needPage].physicalPage = pageTable[outPage].physicalPage;
         pageTable[outPage].physicalPage = -1;
         pageTable[outPage].valid = FALSE;
-        printf("将页 %d 换出到交换文件\n", outPage);
+        printf("将页 %d 换出到交换区\n", outPage);
+        if (frameTable != NULL)
+            frameTable->Assign(pageTable[needPage].physicalPage, this, needPage);
+        pageInMem[idx] = needPage;
+        idx = (idx + 1) % numResident;
     }
-    pageInMem[idx] = needPage;
-    idx = (idx + 1) % maxFramesPerProc;
     pageTable[needPage].valid = TRUE;
     pageTable[needPage].use = TRUE;
     pageTable[needPage].dirty = FALSE;
+    age[needPage] = 0;
 
-    swapFile->ReadAt(&(machine->mainMemory[pageTable[needPage].physicalPage * PageSize]),
-                     PageSize, needPage * PageSize);
+    if (swapSlot[needPage] >= 0)
+    {
+        swapDevice->ReadPage(swapSlot[needPage],
+                             &(machine->mainMemory[pageTable[needPage].physicalPage * PageSize]));
+        stats->numSwapReads++;
+    }
+    else
+        LoadPage(needPage);
     print();
 }
 
-OpenFile *AddrSpace::CreateSwapFile(int pageSize)
+// 页在交换区中没有副本时，按可执行文件的内容构造它：
+// 与代码段、初始化数据段重叠的部分从可执行文件读入，其余部分填零
+void AddrSpace::LoadPage(int page)
 {
-    char swapFileName[20];
-    sprintf(swapFileName, "SWAP%d", spaceId);
-    if (!fileSystem->Create(swapFileName, 0))
-    {
-        printf("无法创建交换文件 %s\n", swapFileName);
-        currentThread->Finish();
-    }
-    swapFile = fileSystem->Open(swapFileName);
-    if (swapFile == NULL)
-    {
-        printf("无法打开交换文件 %s\n", swapFileName);
-        currentThread->Finish();
-    }
-    char *pageBuf = new char[PageSize];
-    bzero(pageBuf, PageSize);
-    for (int i = 0; i < numPages; i++)
-        swapFile->WriteAt(pageBuf, PageSize, i * PageSize);
-    delete[] pageBuf;
-    return swapFile;
+    char *frame = &(machine->mainMemory[pageTable[page].physicalPage * PageSize]);
+    bool fromFile;
+
+    bzero(frame, PageSize);
+    fromFile = ReadSegment(&code, frame, page * PageSize);
+    fromFile = ReadSegment(&initData, frame, page * PageSize) || fromFile;
+    if (fromFile)
+        stats->numExecReads++;
+    else
+        stats->numZeroFills++;
+}
+
+// 读入段中落在 [pageAddr, pageAddr + PageSize) 的部分，没有重叠时返回 FALSE
+bool AddrSpace::ReadSegment(Segment *seg, char *frame, int pageAddr)
+{
+    int from = max(seg->virtualAddr, pageAddr);
+    int to = min(seg->virtualAddr + seg->size, pageAddr + PageSize);
+
+    if (from >= to)
+        return FALSE;
+    execFile->ReadAt(frame + from - pageAddr, to - from,
+                     seg->inFileAddr + from - seg->virtualAddr);
+    return TRUE;
 }
 
 static void SwapHeader(NoffHeader *noffH)
@@ -134,43 +325,54 @@ AddrSpace::AddrSpace(OpenFile *executable)
         pageTable[i].readOnly = FALSE;
     }
 
-    CreateSwapFile(PageSize);
-
-    if (noffH.code.size > 0)
-    {
-        DEBUG('a', "初始化代码段，地址 0x%x，大小 %d\n",
-              noffH.code.virtualAddr, noffH.code.size);
-        char *buf = new char[noffH.code.size];
-        executable->ReadAt(buf, noffH.code.size, noffH.code.inFileAddr);
-        swapFile->WriteAt(buf, noffH.code.size, noffH.code.virtualAddr);
-        delete[] buf;
-    }
-    if (noffH.initData.size > 0)
-    {
-        DEBUG('a', "初始化数据段，地址 0x%x，大小 %d\n",
-              noffH.initData.virtualAddr, noffH.initData.size);
-        char *buf = new char[noffH.initData.size];
-        executable->ReadAt(buf, noffH.initData.size, noffH.initData.inFileAddr);
-        swapFile->WriteAt(buf, noffH.initData.size, noffH.initData.virtualAddr);
-        delete[] buf;
-    }
+    execFile = executable; // 代码和数据在页错误时才从可执行文件读入
+    code = noffH.code;
+    initData = noffH.initData;
+    swapSlot = new int[numPages];
+    for (i = 0; i < numPages; i++)
+        swapSlot[i] = -1;
 
     print();
 
-    pageInMem = new int[maxFramesPerProc];
-    for (i = 0; i < maxFramesPerProc; i++)
-        pageInMem[i] = -1;
+    pageInMem = new int[numPages];
+    numResident = 0;
+    frameLimit = maxFramesPerProc;
     idx = 0;
+    lastFaultTick = stats->userTicks;
+    age = new unsigned int[numPages];
+    for (i = 0; i < numPages; i++)
+        age[i] = 0;
+    recorder = NULL;
+    if (recordRefs)
+    {
+        char refFileName[20];
+        sprintf(refFileName, "REFSTR%d", spaceId);
+        recorder = new RefRecorder(refFileName, numPages);
+    }
     return;
 }
 
 AddrSpace::~AddrSpace()
 {
-    for (unsigned int i = 0; i < numPages; i++)
+    for (int i = 0; i < numResident; i++)
     {
-        freePhys_Map->Clear(pageTable[i].physicalPage);
+        int frame = pageTable[pageInMem[i]].physicalPage;
+        if (frameTable != NULL)
+            frameTable->Release(frame);
+        else
+            freePhys_Map->Clear(frame);
     }
+    if (machine->tlb != NULL)
+        machine->tlb->FlushASID(spaceId); // TLB项指向这个页表
     delete[] pageTable;
+    delete[] pageInMem;
+    delete[] age;
+    for (unsigned int i = 0; i < numPages; i++)
+        if (swapSlot[i] >= 0)
+            swapDevice->Free(swapSlot[i]); // 归还交换槽
+    delete[] swapSlot;
+    delete recorder;
+    delete execFile;
 }
 
 void AddrSpace::InitRegisters()
@@ -196,4 +398,6 @@ void AddrSpace::RestoreState()
 {
     machine->pageTable = pageTable;
     machine->pageTableSize = numPages;
+    machine->asid = spaceId; // TLB项以地址空间标识为标记，切换时无需清空
+    refRecorder = recorder;
 }
@@ -1,20 +1,28 @@
 // addrspace.h修改自test/addresspacae.h
 // 添加print方法
+// 换出的页由 replacePolicy 选择的页置换算法决定
+// 全局置换时帧数上限随缺页频率变化
+// 页按需从可执行文件读入或填零，交换区只保存换出过的脏页
 
 #ifndef ADDRSPACE_H
 #define ADDRSPACE_H
 
 #include "../machine/translate.h"
 #include "filesys.h"
+#include "refrec.h"
+#include "noff.h"
 
 #define UserStackSize 1024 // 根据需要增加这个值！
+#define PFFInterval 200     // 全局置换时，两次页错误间隔的用户时钟周期数
+                            // 小于它时扩大驻留集，否则缩小
 
 class AddrSpace
 {
 public:
   AddrSpace(OpenFile *executable); // 创建一个地址空间，
-                                   // 用存储在文件 "executable" 中的程序初始化它
-  ~AddrSpace();                    // 释放地址空间
+                                   // 用存储在文件 "executable" 中的程序初始化它，
+                                   // 并接管这个文件
+  ~AddrSpace();                    // 释放地址空间，关闭可执行文件
 
   void InitRegisters(); // 初始化用户级 CPU 寄存器，
                         // 在跳转到用户代码之前
@@ -24,13 +32,19 @@ public:
 
   void print();
 
-  int FindPageOut();
+  int FindPageOut(); // 选出要换出的页，内存未满时返回 -1
 
-  OpenFile *CreateSwapFile(int pageSize);
-  OpenFile *GetSwapFile() { return swapFile; }
   void WriteToSwap(int outPage);
   void GetPageToMem(int needPage);
 
+  bool TestAndClearUse(int page) // 给帧表的全局时钟用
+  {
+    bool used = pageTable[page].use;
+    pageTable[page].use = FALSE;
+    return used;
+  }
+  void StealPage(int page, bool shrink); // 帧表取走这一页的帧
+
   int getSpaceId() { return spaceId; }
 
 private:
@@ -38,10 +52,28 @@ private:
                                // 现在就这样！
   unsigned int numPages;       // 虚拟地址空间中的页数
   int spaceId;
-  OpenFile *swapFile;
+  OpenFile *execFile;        // 可执行文件，页错误时从中读入代码和数据
+  Segment code, initData;    // 可执行文件中的代码段和初始化数据段
+  int *swapSlot;             // 页在交换区中的槽，没有副本时为 -1
+
+  int *pageInMem;    // 在内存中的页，按进入内存的先后排成环
+  int numResident;   // 在内存中的页数
+  int frameLimit;    // 帧数上限，固定分配时就是 maxFramesPerProc
+  int idx;           // 记录最先进入内存的页，也是时钟算法的指针
+  int lastFaultTick; // 上次页错误时的用户时钟周期
+  unsigned int *age; // 近似 LRU 的老化计数器，按虚拟页
+  RefRecorder *recorder; // 引用串记录器，不记录时为 NULL
 
-  int *pageInMem; // 在内存中的页
-  int idx;        // 记录最先进入内存的页
+  int FindClock();
+  int FindEnhanced();
+  int FindLRU();
+  void AgePages(); // 把 use 位移入老化计数器并清除
+  void InsertResident(int page);
+  void RemoveResident(int page);
+  void EvictPage(int page);
+  void AdjustResidentSet(); // 缺页频率控制
+  void LoadPage(int page);   // 从可执行文件读入或填零
+  bool ReadSegment(Segment *seg, char *frame, int pageAddr);
 };
 
 #endif // ADDRSPACE_H
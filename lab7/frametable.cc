@@ -0,0 +1,53 @@
+// frametable.cc
+// 全局置换的物理帧表，见 frametable.h
+
+#include "system.h"
+#include "frametable.h"
+#include "addrspace.h"
+
+FrameTable::FrameTable()
+{
+    for (int i = 0; i < NumPhysPages; i++)
+    {
+        owner[i] = NULL;
+        virtualPage[i] = -1;
+    }
+    hand = 0;
+}
+
+// 优先使用空闲帧。没有空闲帧时，指针跳过 use 位为真的页并清除它们的
+// use 位，最多两圈就能找到一页；该页所属的进程失去这一帧
+int FrameTable::Allocate(AddrSpace *as, int vpn)
+{
+    int frame = freePhys_Map->Find();
+
+    if (frame < 0)
+    {
+        for (;;)
+        {
+            frame = hand;
+            hand = (hand + 1) % NumPhysPages;
+            if (owner[frame] != NULL && !owner[frame]->TestAndClearUse(virtualPage[frame]))
+                break;
+        }
+        if (owner[frame] != as)
+            stats->numFramesStolen++;
+        printf("从地址空间 %d 取走物理页 %d\n", owner[frame]->getSpaceId(), frame);
+        owner[frame]->StealPage(virtualPage[frame], owner[frame] != as);
+    }
+    Assign(frame, as, vpn);
+    return frame;
+}
+
+void FrameTable::Assign(int frame, AddrSpace *as, int vpn)
+{
+    owner[frame] = as;
+    virtualPage[frame] = vpn;
+}
+
+void FrameTable::Release(int frame)
+{
+    owner[frame] = NULL;
+    virtualPage[frame] = -1;
+    freePhys_Map->Clear(frame);
+}
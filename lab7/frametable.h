@@ -0,0 +1,28 @@
+// frametable.h
+// 全局置换（-gf）时所有用户进程共享的物理帧表。
+// 记录每一帧属于哪个地址空间的哪一页；没有空闲帧时，
+// 用全局时钟算法从任意进程的驻留页中取出一帧。
+
+#ifndef FRAMETABLE_H
+#define FRAMETABLE_H
+
+#include "machine.h"
+
+class AddrSpace;
+
+class FrameTable
+{
+public:
+  FrameTable();
+
+  int Allocate(AddrSpace *as, int vpn);             // 为 as 的 vpn 取一帧
+  void Assign(int frame, AddrSpace *as, int vpn);    // 帧改为存放 as 的 vpn
+  void Release(int frame);                           // 归还到 freePhys_Map
+
+private:
+  AddrSpace *owner[NumPhysPages]; // 帧所属的地址空间，空闲时为 NULL
+  int virtualPage[NumPhysPages];  // 帧中存放的虚拟页
+  int hand;                       // 全局时钟的指针
+};
+
+#endif // FRAMETABLE_H
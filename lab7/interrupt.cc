@@ -35,22 +35,34 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, _int param, int time,
     arg = param;
     when = time;
     type = kind;
+    next = NULL;
 }
 
 Interrupt::Interrupt()
 {
     level = IntOff;
-    pending = new List();
+    pending = new EventQueue();
+    freeList = NULL;
     inHandler = FALSE;
     yieldOnReturn = FALSE;
     status = SystemMode;
+    nextDue = NoPendingTime;
+    traceTicks = DebugIsEnabled('i');
 }
 
 Interrupt::~Interrupt()
 {
-    while (!pending->IsEmpty())
-        delete (ListElement *)(pending->Remove());
+    PendingInterrupt *toOccur;
+
+    while ((toOccur = (PendingInterrupt *)pending->RemoveMin(NULL)) != NULL)
+        delete toOccur;
     delete pending;
+    while (freeList != NULL)
+    {
+        toOccur = freeList;
+        freeList = toOccur->next;
+        delete toOccur;
+    }
 }
 
 void Interrupt::ChangeLevel(IntStatus old, IntStatus now)
@@ -77,20 +89,23 @@ void Interrupt::Enable()
     (void)SetLevel(IntOn);
 }
 
-void Interrupt::OneTick()
+void Interrupt::OneTick(int count)
 {
     MachineStatus old = status;
 
     if (status == SystemMode)
     {
-        stats->totalTicks += SystemTick;
-        stats->systemTicks += SystemTick;
+        stats->totalTicks += SystemTick * count;
+        stats->systemTicks += SystemTick * count;
     }
     else
     {
-        stats->totalTicks += UserTick;
-        stats->userTicks += UserTick;
+        stats->totalTicks += UserTick * count;
+        stats->userTicks += UserTick * count;
     }
+
+    if (stats->totalTicks < nextDue && !yieldOnReturn && !traceTicks)
+        return; // 下一个待处理中断还未到期
     DEBUG('i', "\n== 时钟 %d ==\n", stats->totalTicks);
 
     ChangeLevel(IntOn, IntOff);
@@ -106,6 +121,14 @@ void Interrupt::OneTick()
     }
 }
 
+// 距离最早的待处理中断到期的时钟数（至少为1）
+int Interrupt::TicksUntilDue()
+{
+    if (traceTicks || nextDue <= stats->totalTicks)
+        return 1;
+    return nextDue - stats->totalTicks;
+}
+
 void Interrupt::YieldOnReturn()
 {
     ASSERT(inHandler == TRUE);
@@ -141,13 +164,27 @@ void Interrupt::Halt()
 void Interrupt::Schedule(VoidFunctionPtr handler, _int arg, int fromNow, IntType type)
 {
     int when = stats->totalTicks + fromNow;
-    PendingInterrupt *toOccur = new PendingInterrupt(handler, arg, when, type);
+    PendingInterrupt *toOccur;
+
+    if (freeList != NULL)
+    { // 重用已触发的中断的节点
+        toOccur = freeList;
+        freeList = toOccur->next;
+        toOccur->handler = handler;
+        toOccur->arg = arg;
+        toOccur->when = when;
+        toOccur->type = type;
+    }
+    else
+        toOccur = new PendingInterrupt(handler, arg, when, type);
 
     DEBUG('i', "调度中断处理程序 %s 在时间 = %d\n",
           intTypeNames[type], when);
     ASSERT(fromNow > 0);
 
-    pending->SortedInsert(toOccur, when);
+    pending->Insert(toOccur, when);
+    if (when < nextDue)
+        nextDue = when;
 }
 
 bool Interrupt::CheckIfDue(bool advanceClock)
@@ -159,10 +196,13 @@ bool Interrupt::CheckIfDue(bool advanceClock)
     if (DebugIsEnabled('i'))
         DumpState();
     PendingInterrupt *toOccur =
-        (PendingInterrupt *)pending->SortedRemove(&when);
+        (PendingInterrupt *)pending->Peek(&when);
 
     if (toOccur == NULL)
+    {
+        nextDue = NoPendingTime;
         return FALSE;
+    }
 
     if (advanceClock && when > stats->totalTicks)
     {
@@ -171,15 +211,16 @@ bool Interrupt::CheckIfDue(bool advanceClock)
     }
     else if (when > stats->totalTicks)
     {
-        pending->SortedInsert(toOccur, when);
+        nextDue = when;
         return FALSE;
     }
 
-    if ((status == IdleMode) && (toOccur->type == TimerInt) && pending->IsEmpty())
+    if ((status == IdleMode) && (toOccur->type == TimerInt) && (pending->NumItems() == 1))
     {
-        pending->SortedInsert(toOccur, when);
+        nextDue = when;
         return FALSE;
     }
+    pending->RemoveMin(NULL);
 
     DEBUG('i', "在时间 %d 调用 %s 的中断处理程序\n",
           intTypeNames[toOccur->type], toOccur->when);
@@ -187,12 +228,15 @@ bool Interrupt::CheckIfDue(bool advanceClock)
     if (machine != NULL)
         machine->DelayedLoad(0, 0);
 #endif
+    if (!pending->Peek(&nextDue)) // 新的队首
+        nextDue = NoPendingTime;
     inHandler = TRUE;
     status = SystemMode;
     (*(toOccur->handler))(toOccur->arg);
     status = old;
     inHandler = FALSE;
-    delete toOccur;
+    toOccur->next = freeList; // 节点放回空闲链表
+    freeList = toOccur;
     return TRUE;
 }
 
@@ -5,6 +5,7 @@
 #define INTERRUPT_H
 
 #include "list.h"
+#include "eventqueue.h"
 
 enum IntStatus
 {
@@ -29,6 +30,8 @@ enum IntType
   NetworkRecvInt
 };
 
+#define NoPendingTime 0x7fffffff // 没有待处理的中断时 nextDue 的值
+
 class PendingInterrupt
 {
 public:
@@ -38,6 +41,7 @@ public:
   _int arg;
   int when;
   IntType type;
+  PendingInterrupt *next; // 空闲链表
 };
 
 class Interrupt
@@ -68,14 +72,18 @@ public:
   void Schedule(VoidFunctionPtr handler, _int arg,
                 int fromnow, IntType type);
 
-  void OneTick();
+  void OneTick(int count = 1);
+  int TicksUntilDue();
 
 private:
   IntStatus level;
-  List *pending;
+  EventQueue *pending;
+  PendingInterrupt *freeList;
   bool inHandler;
   bool yieldOnReturn;
   MachineStatus status;
+  int nextDue;
+  bool traceTicks;
 
   bool CheckIfDue(bool advanceClock);
 
@@ -9,7 +9,8 @@
 // 	此文件的大部分内容在后续作业中不需要。
 //
 // 用法: nachos -d <调试标志> -rs <随机种子 #>
-//		-s -x <nachos 文件> -c <控制台输入> <控制台输出>
+//		-s -bb -dump <文件> -tlb <条目数> <相联度> <策略> -mf <帧数> -pra <算法>
+//		-x <nachos 文件> -c <控制台输入> <控制台输出>
 //		-f -cp <unix 文件> <nachos 文件>
 //		-p <nachos 文件> -r <nachos 文件> -l -D -t
 //              -n <网络可靠性> -e <网络可达性>
@@ -22,6 +23,14 @@
 //
 //  用户程序
 //    -s 会导致用户程序以单步模式执行
+//    -bb 以基本块翻译模式执行用户程序（单步调试时无效）
+//    -dump 停机时把寄存器、用户时钟和主存写到文件，用于比较 -bb 与解释执行
+//    -tlb 使用带地址空间标识的组相联 TLB，策略为 lru、fifo 或 random
+//    -mf 每个用户进程分配的最大帧数，默认为 5
+//    -pra 页置换算法：1 FIFO（默认），2 时钟，3 增强型二次机会，
+//         4 近似 LRU，>= 5 随机（参数同时作为随机数种子）；
+//         为负值时使用相应的算法，并把引用串记录到 REFSTRn，
+//         用 ../bin/refstat 分析
 //    -x 运行一个用户程序
 //    -c 测试控制台
 //
@@ -91,6 +100,33 @@ int main(int argc, char **argv)
             argCount = 2;
             continue;
         }
+        if (!strcmp(*argv, "-gf"))
+        { // 全局置换，-mf 给出每个进程的初始帧数
+            if (frameTable == NULL)
+                frameTable = new FrameTable();
+            continue;
+        }
+        if (!strcmp(*argv, "-pra"))
+        {
+            ASSERT(argc > 1);
+            int pra = atoi(*(argv + 1));
+            if (pra < 0)
+            { // 负值表示记录引用串，见 n7readme.txt
+                recordRefs = TRUE;
+                pra = -pra;
+            }
+            if (pra == ReplaceOPT)
+                printf("最优页置换需要引用串文件，仍使用 FIFO\n");
+            else if (pra >= ReplaceRandom)
+            {
+                replacePolicy = ReplaceRandom;
+                RandomInit(pra);
+            }
+            else
+                replacePolicy = (ReplacePolicy)pra;
+            argCount = 2;
+            continue;
+        }
 
         if (!strcmp(*argv, "-x"))
         { // 运行一个用户程序
@@ -1,5 +1,6 @@
 // progtest.cc 复制自 lab6/progtest.cc
-// 无修改
+// 可执行文件交给地址空间，页错误时从中读入代码和数据
+// Exec 替换调用者的地址空间，旧的地址空间在这里释放
 
 #include "system.h"
 #include "console.h"
@@ -10,6 +11,7 @@ int StartProcess(char *filename)
 {
     OpenFile *executable = fileSystem->Open(filename);
     AddrSpace *space;
+    AddrSpace *oldSpace = currentThread->space;
 
     if (executable == NULL)
     {
@@ -18,7 +20,7 @@ int StartProcess(char *filename)
     }
     space = new AddrSpace(executable);
     currentThread->space = space;
-    delete executable;
+    delete oldSpace; // 归还它的帧和交换槽
 
     space->InitRegisters();
     space->RestoreState();
@@ -0,0 +1,71 @@
+// refrec.cc
+// 页引用串的记录器
+
+#include "machine.h"
+#include "refrec.h"
+
+RefRecorder *refRecorder = NULL;
+
+static RefRecorder *allRecorders = NULL; // Halt 时仍在运行的地址空间没有
+                                         // 被释放，结束时统一写回
+
+RefRecorder::RefRecorder(char *fileName, int numPages)
+{
+    RefStrHeader header;
+
+    fd = OpenForWrite(fileName);
+    header.magic = REFSTRMAGIC;
+    header.pageSize = PageSize;
+    header.numPages = numPages;
+    WriteFile(fd, (char *)&header, sizeof(header));
+    lastPage = -1;
+    lastWrite = FALSE;
+    runLength = 0;
+    numBuffered = 0;
+    next = allRecorders;
+    allRecorders = this;
+}
+
+RefRecorder::~RefRecorder()
+{
+    RefRecorder **prev;
+
+    Flush();
+    Close(fd);
+    for (prev = &allRecorders; *prev != this; prev = &(*prev)->next)
+        ;
+    *prev = next;
+    if (refRecorder == this)
+        refRecorder = NULL;
+}
+
+void RefRecorder::StartRun(int vpn, bool writing)
+{
+    if (lastPage != -1)
+    {
+        buffer[numBuffered++] = RefRecord(lastPage, lastWrite, runLength);
+        if (numBuffered == RefBufferWords)
+        {
+            WriteFile(fd, (char *)buffer, numBuffered * sizeof(unsigned int));
+            numBuffered = 0;
+        }
+    }
+    lastPage = vpn;
+    lastWrite = writing;
+    runLength = 1;
+}
+
+void RefRecorder::Flush()
+{
+    StartRun(-1, FALSE); // 结束合并中的记录
+    if (numBuffered > 0)
+        WriteFile(fd, (char *)buffer, numBuffered * sizeof(unsigned int));
+    numBuffered = 0;
+    lastPage = -1;
+}
+
+void RefRecorder::FlushAll()
+{
+    for (RefRecorder *r = allRecorders; r != NULL; r = r->next)
+        r->Flush();
+}
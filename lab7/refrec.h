@@ -0,0 +1,45 @@
+// refrec.h
+// 页引用串的记录器，格式见 ../bin/refstr.h
+// 由 -pra 的负值打开，每个用户进程写一个文件 REFSTRn。
+// 记录先在内存中合并、缓冲，缓冲区满或结束时才写到文件。
+
+#ifndef REFREC_H
+#define REFREC_H
+
+#include "utility.h"
+#include "refstr.h"
+
+#define RefBufferWords 4096 // 缓冲的记录数
+
+class RefRecorder
+{
+public:
+  RefRecorder(char *fileName, int numPages); // 创建文件并写入文件头
+  ~RefRecorder();                            // 写回缓冲区并关闭文件
+
+  void Record(int vpn, bool writing) // 记录一次成功的地址转换
+  {
+    if (vpn == lastPage && writing == lastWrite && runLength < RefMaxRun)
+      runLength++;
+    else
+      StartRun(vpn, writing);
+  }
+  void Flush(); // 把合并中的记录和缓冲区写到文件
+
+  static void FlushAll(); // 写回所有记录器，Nachos 结束时调用
+
+private:
+  int fd;
+  int lastPage; // 正在合并的记录，-1 表示没有
+  bool lastWrite;
+  int runLength;
+  unsigned int buffer[RefBufferWords];
+  int numBuffered;
+  RefRecorder *next; // 所有记录器的链表
+
+  void StartRun(int vpn, bool writing);
+};
+
+extern RefRecorder *refRecorder; // 当前地址空间的记录器，不记录时为 NULL
+
+#endif // REFREC_H
@@ -1,5 +1,8 @@
 // stats.cc 修改自 machine/stats.cc
 // 增加了numPageWrites的初始化和输出
+// 增加了按页置换算法的统计
+// 增加了全局置换的统计
+// 增加了交换区和磁盘的统计
 
 #include "utility.h"
 #include "stats.h"
@@ -8,9 +11,19 @@ Statistics::Statistics()
 {
     totalTicks = idleTicks = systemTicks = userTicks = 0;
     numDiskReads = numDiskWrites = 0;
+    numDiskSectorsRead = numDiskSectorsWritten = 0;
+    numDiskTracksMoved = numDiskRequests = diskRequestTicks = 0;
+    numCacheHits = numCacheMisses = numCacheWriteBacks = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
     numPageWrites = 0; // 初始化为0
+    for (int i = 0; i <= MaxStatSpaces; i++)
+        tlbHits[i] = tlbMisses[i] = tlbEvictions[i] = 0;
+    for (int i = 0; i < NumReplacePolicies; i++)
+        policyFaults[i] = policyPageOuts[i] = policyPageWrites[i] = 0;
+    numFramesStolen = numResidentGrows = numResidentShrinks = numFramesReleased = 0;
+    numZeroFills = numExecReads = numSwapReads = 0;
+    numSwapSlots = swapSlotsInUse = maxSwapSlotsInUse = 0;
 }
 
 void Statistics::Print()
@@ -18,9 +31,61 @@ void Statistics::Print()
     printf("时钟周期: 总计 %d, 空闲 %d, 系统 %d, 用户 %d\n", totalTicks,
            idleTicks, systemTicks, userTicks);
     printf("磁盘I/O: 读取 %d, 写入 %d\n", numDiskReads, numDiskWrites);
+    if (numDiskSectorsRead + numDiskSectorsWritten != numDiskReads + numDiskWrites)
+        printf("磁盘扇区: 读取 %d, 写入 %d\n", numDiskSectorsRead,
+               numDiskSectorsWritten); // 有多扇区请求
+    if (numDiskRequests > 0)
+        printf("磁盘调度: 磁头移动 %d 道, 平均请求延迟 %d\n",
+               numDiskTracksMoved, diskRequestTicks / numDiskRequests);
     printf("控制台I/O: 读取 %d, 写入 %d\n", numConsoleCharsRead,
            numConsoleCharsWritten);
     printf("分页: 页面错误 %d,写回%d\n", numPageFaults, numPageWrites); // 输出写回
     printf("网络I/O: 接收的数据包 %d, 发送的数据包 %d\n", numPacketsRecvd,
            numPacketsSent);
+    PrintPaging();
+    PrintTLB();
+}
+
+// 打印每种页置换算法的统计信息，没有页面错误时不打印
+void Statistics::PrintPaging()
+{
+    static const char *names[NumReplacePolicies] = {
+        "OPT", "FIFO", "Clock", "增强型二次机会", "LRU", "随机"};
+
+    for (int i = 0; i < NumReplacePolicies; i++)
+        if (policyFaults[i] > 0)
+            printf("页置换 %s: 页面错误 %d, 换出 %d, 写回 %d\n", names[i],
+                   policyFaults[i], policyPageOuts[i], policyPageWrites[i]);
+    if (numPageFaults > 0)
+        printf("换入: 填零 %d, 从可执行文件读入 %d, 从交换区读入 %d\n",
+               numZeroFills, numExecReads, numSwapReads);
+    if (numSwapSlots > 0)
+        printf("交换区: 槽 %d 个, 使用中 %d, 最多同时使用 %d\n",
+               numSwapSlots, swapSlotsInUse, maxSwapSlotsInUse);
+    if (numResidentGrows + numResidentShrinks + numFramesStolen > 0)
+        printf("全局置换: 驻留集扩大 %d 次, 缩小 %d 次（释放 %d 帧）, 从其他进程取得 %d 帧\n",
+               numResidentGrows, numResidentShrinks, numFramesReleased, numFramesStolen);
+}
+
+// 打印 TLB 的统计信息，没有使用 TLB 时不打印
+void Statistics::PrintTLB()
+{
+    int i, hits = 0, misses = 0, evictions = 0;
+
+    for (i = 0; i <= MaxStatSpaces; i++)
+    {
+        hits += tlbHits[i];
+        misses += tlbMisses[i];
+        evictions += tlbEvictions[i];
+    }
+    if (hits + misses == 0)
+        return;
+    printf("TLB: 命中 %d, 未命中 %d, 替换 %d\n", hits, misses, evictions);
+    for (i = 0; i < MaxStatSpaces; i++)
+        if (tlbHits[i] + tlbMisses[i] + tlbEvictions[i] > 0)
+            printf("  地址空间 %d: 命中 %d, 未命中 %d, 替换 %d\n", i,
+                   tlbHits[i], tlbMisses[i], tlbEvictions[i]);
+    if (tlbHits[i] + tlbMisses[i] + tlbEvictions[i] > 0)
+        printf("  其他地址空间: 命中 %d, 未命中 %d, 替换 %d\n",
+               tlbHits[i], tlbMisses[i], tlbEvictions[i]);
 }
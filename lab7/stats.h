@@ -1,8 +1,14 @@
 // status.h 修改自 machine/stats.h
 // 添加了numPageWrites
+// 按页置换算法分别统计页面错误和写回
+// 增加了交换设备及其磁盘的统计
 #ifndef STATS_H
 #define STATS_H
 
+#define MaxStatSpaces 16 // 分别统计 TLB 的地址空间数，其余的合计在下标 MaxStatSpaces 中
+#define StatSpace(asid) (((asid) >= 0 && (asid) < MaxStatSpaces) ? (asid) : MaxStatSpaces)
+#define NumReplacePolicies 6 // 页置换算法数，与 -pra 的编号一致
+
 class Statistics
 {
 public:
@@ -13,6 +19,14 @@ public:
 
   int numDiskReads;
   int numDiskWrites;
+  int numDiskSectorsRead;    // 读取的磁盘扇区数（一个请求可含多个扇区）
+  int numDiskSectorsWritten; // 写入的磁盘扇区数
+  int numDiskTracksMoved;    // 磁头移动经过的轨道数
+  int numDiskRequests;       // SynchDisk 完成的请求数（合并前）
+  int diskRequestTicks;      // 这些请求从提交到完成的总时间
+  int numCacheHits;          // 扇区缓存命中的次数
+  int numCacheMisses;        // 扇区缓存未命中的次数
+  int numCacheWriteBacks;    // 脏扇区写回磁盘的次数
   int numConsoleCharsRead;
   int numConsoleCharsWritten;
   int numPageFaults;
@@ -20,9 +34,32 @@ public:
   int numPacketsSent;
   int numPacketsRecvd;
 
+  int tlbHits[MaxStatSpaces + 1];      // 每个地址空间的 TLB 命中次数
+  int tlbMisses[MaxStatSpaces + 1];    // TLB 未命中次数
+  int tlbEvictions[MaxStatSpaces + 1]; // TLB 项被替换的次数
+
+  int policyFaults[NumReplacePolicies];    // 每种页置换算法下的页面错误次数
+  int policyPageOuts[NumReplacePolicies];  // 被换出的页数
+  int policyPageWrites[NumReplacePolicies]; // 换出时写回交换文件的页数
+
+  int numFramesStolen;    // 全局置换时从其他进程取得的帧数
+  int numResidentGrows;   // 驻留集扩大的次数
+  int numResidentShrinks; // 驻留集缩小的次数
+  int numFramesReleased;  // 缩小时释放的帧数
+
+  int numZeroFills; // 页错误时填零的页数
+  int numExecReads; // 从可执行文件读入的页数
+  int numSwapReads; // 从交换区读入的页数
+
+  int numSwapSlots;      // 交换区的槽数
+  int swapSlotsInUse;    // 已分配的槽数
+  int maxSwapSlotsInUse; // 同时分配的最多槽数
+
   Statistics();
 
   void Print();
+  void PrintTLB();
+  void PrintPaging();
 };
 
 #define UserTick 1
@@ -0,0 +1,51 @@
+// swapdev.cc
+// 交换设备，见 swapdev.h
+
+#include "system.h"
+#include "swapdev.h"
+
+SwapDevice::SwapDevice(SynchDisk *dev, int first, int numSectors)
+{
+    disk = dev;
+    firstSector = first;
+    numSlots = numSectors / SectorsPerPage;
+    slotMap = new BitMap(numSlots);
+    stats->numSwapSlots = numSlots;
+}
+
+SwapDevice::~SwapDevice()
+{
+    delete slotMap;
+}
+
+int SwapDevice::Allocate()
+{
+    int slot = slotMap->Find();
+
+    if (slot < 0)
+        return -1;
+    stats->swapSlotsInUse++;
+    if (stats->swapSlotsInUse > stats->maxSwapSlotsInUse)
+        stats->maxSwapSlotsInUse = stats->swapSlotsInUse;
+    return slot;
+}
+
+void SwapDevice::Free(int slot)
+{
+    ASSERT(slotMap->Test(slot));
+    slotMap->Clear(slot);
+    stats->swapSlotsInUse--;
+}
+
+// 一个槽的扇区是连续的，一次多扇区请求就能读写整页
+void SwapDevice::ReadPage(int slot, char *data)
+{
+    ASSERT(slotMap->Test(slot));
+    disk->ReadSectors(firstSector + slot * SectorsPerPage, SectorsPerPage, data);
+}
+
+void SwapDevice::WritePage(int slot, char *data)
+{
+    ASSERT(slotMap->Test(slot));
+    disk->WriteSectors(firstSector + slot * SectorsPerPage, SectorsPerPage, data);
+}
@@ -0,0 +1,36 @@
+// swapdev.h
+// 交换设备：磁盘上预留给交换区的一段连续扇区，按页划分为槽，
+// 用自己的位图分配。页的换入换出直接用 SynchDisk 读写槽中的扇区，
+// 不经过文件系统。
+// lab7 使用 FILESYS_STUB，没有 Nachos 文件系统，交换区是单独的
+// 磁盘映像 SWAPDISK 的全部扇区。
+
+#ifndef SWAPDEV_H
+#define SWAPDEV_H
+
+#include "machine.h"
+#include "bitmap.h"
+#include "synchdisk.h"
+
+#define SectorsPerPage divRoundUp(PageSize, SectorSize) // 每个槽的扇区数
+
+class SwapDevice
+{
+public:
+  SwapDevice(SynchDisk *dev, int first, int numSectors);
+  // 交换区是 dev 上从 first 开始的 numSectors 个扇区
+  ~SwapDevice();
+
+  int Allocate();        // 分配一个槽，交换区已满时返回 -1
+  void Free(int slot);   // 进程结束时归还它的槽
+  void ReadPage(int slot, char *data);  // 读入一页
+  void WritePage(int slot, char *data); // 写出一页
+
+private:
+  SynchDisk *disk;
+  int firstSector; // 交换区的第一个扇区
+  int numSlots;
+  BitMap *slotMap; // 已分配的槽
+};
+
+#endif // SWAPDEV_H
@@ -1,7 +1,11 @@
 // system.cc 修改自 threads/system.cc
 // 增加了freePhys_Map的初始化
+// 增加了交换设备的初始化
 
 #include "system.h"
+#ifdef USER_PROGRAM
+#include "refrec.h"
+#endif
 
 // 这定义了 *所有* 用于 Nachos 的全局数据结构。
 // 这些都由此文件初始化和释放。
@@ -27,6 +31,11 @@ Machine *machine;   // 用户程序内存和寄存器
 BitMap *freePhys_Map;
 int space;
 int maxFramesPerProc = 5; // 每个用户进程分配的最大帧数
+ReplacePolicy replacePolicy = ReplaceFIFO; // 页置换算法
+bool recordRefs = FALSE;                   // 是否记录引用串
+FrameTable *frameTable = NULL;             // 全局置换的帧表
+SynchDisk *swapDisk;                       // 交换区所在的磁盘
+SwapDevice *swapDevice;                    // 交换区
 int *needpage;
 #endif
 
@@ -77,6 +86,11 @@ void Initialize(int argc, char **argv)
 
 #ifdef USER_PROGRAM
   bool debugUserProg = FALSE; // 单步调试用户程序
+  bool translateUserProg = FALSE; // 以基本块翻译模式执行用户程序
+  char *stateFile = NULL;         // 停机时写出机器状态的文件
+  int tlbEntries = 0;             // TLB 条目数，0 表示使用编译时的设置
+  int tlbWays = 0;                // TLB 相联度
+  TLBPolicy tlbPolicy = TLBLRU;   // TLB 替换策略
 #endif
 #ifdef FILESYS_NEEDED
   bool format = FALSE; // 格式化磁盘
@@ -111,6 +125,27 @@ void Initialize(int argc, char **argv)
 #ifdef USER_PROGRAM
     if (!strcmp(*argv, "-s"))
       debugUserProg = TRUE;
+    else if (!strcmp(*argv, "-bb"))
+      translateUserProg = TRUE;
+    else if (!strcmp(*argv, "-dump"))
+    {
+      ASSERT(argc > 1);
+      stateFile = *(argv + 1);
+      argCount = 2;
+    }
+    else if (!strcmp(*argv, "-tlb"))
+    {
+      ASSERT(argc > 3);
+      tlbEntries = atoi(*(argv + 1));
+      tlbWays = atoi(*(argv + 2));
+      if (!strcmp(*(argv + 3), "fifo"))
+        tlbPolicy = TLBFIFO;
+      else if (!strcmp(*(argv + 3), "random"))
+        tlbPolicy = TLBRandom;
+      else
+        ASSERT(!strcmp(*(argv + 3), "lru"));
+      argCount = 4;
+    }
 #endif
 #ifdef FILESYS_NEEDED
     if (!strcmp(*argv, "-f"))
@@ -157,9 +192,14 @@ void Initialize(int argc, char **argv)
   CallOnUserAbort(Cleanup); // 如果用户按下 ctl-C
 
 #ifdef USER_PROGRAM
-  machine = new Machine(debugUserProg); // 这必须先执行
+  machine = new Machine(debugUserProg, translateUserProg); // 这必须先执行
+  if (tlbEntries > 0)
+    machine->UseTLB(tlbEntries, tlbWays, tlbPolicy);
+  machine->stateFile = stateFile;
   freePhys_Map = new BitMap(NumPhysPages);
   space = 0;
+  swapDisk = new SynchDisk("SWAPDISK");
+  swapDevice = new SwapDevice(swapDisk, 0, NumSectors); // 整个磁盘都用作交换区
 #endif
 
 #ifdef FILESYS
@@ -187,7 +227,10 @@ void Cleanup()
 #endif
 
 #ifdef USER_PROGRAM
+  RefRecorder::FlushAll(); // Halt 时仍在运行的地址空间没有被释放，在这里写回它的引用串
   delete machine;
+  delete swapDevice;
+  delete swapDisk;
 #endif
 
 #ifdef FILESYS_NEEDED
@@ -25,10 +25,28 @@ extern Timer *timer;				// 硬件闹钟
 #ifdef USER_PROGRAM
 #include "machine.h"
 #include "bitmap.h"
+#include "frametable.h"
+#include "swapdev.h"
 extern Machine *machine; // 用户程序内存和寄存器
 extern BitMap *freePhys_Map;
 extern int space;
 extern int maxFramesPerProc;		 // 每个用户进程分配的最大帧数
+
+// 页置换算法，编号与 -pra 的参数一致
+enum ReplacePolicy
+{
+	ReplaceOPT,		 // 最优（需要引用串）
+	ReplaceFIFO,	 // 先进先出
+	ReplaceClock,	 // 二次机会（时钟）
+	ReplaceEnhanced, // 增强型二次机会，同时看 use 和 dirty 位
+	ReplaceLRU,		 // 用老化计数器近似的 LRU
+	ReplaceRandom	 // 随机
+};
+extern ReplacePolicy replacePolicy; // 用户进程的页置换算法
+extern bool recordRefs;				// 是否为每个用户进程记录引用串 REFSTRn
+extern FrameTable *frameTable;		// 全局置换的帧表，局部置换时为 NULL
+extern SynchDisk *swapDisk;			// 交换区所在的磁盘
+extern SwapDevice *swapDevice;		// 交换区
 #endif
 
 #ifdef FILESYS_NEEDED // FILESYS 或 FILESYS_STUB
@@ -1,10 +1,12 @@
 // translate.cc 
 // 获取读取的页
+// 记录引用串：每次成功的地址转换记入 refRecorder
 
 
 #include "machine.h"
 #include "addrspace.h"
 #include "system.h"
+#include "refrec.h"
 
 // 将字和短字转换为模拟机器的小端格式的例程。
 // 当主机机器也是小端时，这些最终会变成NOP（DEC和Intel）。
@@ -60,34 +62,41 @@ Machine::ReadMem(int addr, int size, int *value)
     int data;
     ExceptionType exception;
     int physicalAddress;
+    char *host;
     
-    DEBUG('a', "读取虚拟地址 0x%x, 大小 %d\n", addr, size);
+    // 快速路径：对齐访问且虚拟页在主机页缓存中
+    if (traceMem || (addr & (size - 1)) != 0
+	    || (host = HostAddress(addr, FALSE)) == NULL) {
+	DEBUG('a', "读取虚拟地址 0x%x, 大小 %d\n", addr, size);
     
-    exception = Translate(addr, &physicalAddress, size, FALSE);
-    if (exception != NoException) {
-	machine->RaiseException(exception, addr);
-	return FALSE;
+	exception = Translate(addr, &physicalAddress, size, FALSE);
+	if (exception != NoException) {
+	    machine->RaiseException(exception, addr);
+	    return FALSE;
+	}
+	host = &mainMemory[physicalAddress];
     }
     switch (size) {
       case 1:
-	data = machine->mainMemory[physicalAddress];
+	data = *host;
 	*value = data;
 	break;
 	
       case 2:
-	data = *(unsigned short *) &machine->mainMemory[physicalAddress];
+	data = *(unsigned short *) host;
 	*value = ShortToHost(data);
 	break;
 	
       case 4:
-	data = *(unsigned int *) &machine->mainMemory[physicalAddress];
+	data = *(unsigned int *) host;
 	*value = WordToHost(data);
 	break;
 
       default: ASSERT(FALSE);
     }
     
-    DEBUG('a', "\t读取的值 = %8.8x\n", *value);
+    if (traceMem)
+	DEBUG('a', "\t读取的值 = %8.8x\n", *value);
     return (TRUE);
 }
 
@@ -108,26 +117,32 @@ Machine::WriteMem(int addr, int size, int value)
 {
     ExceptionType exception;
     int physicalAddress;
+    char *host;
      
-    DEBUG('a', "写入虚拟地址 0x%x, 大小 %d, 值 0x%x\n", addr, size, value);
+    // 快速路径：对齐访问且虚拟页在主机页缓存中
+    if (traceMem || (addr & (size - 1)) != 0
+	    || (host = HostAddress(addr, TRUE)) == NULL) {
+	DEBUG('a', "写入虚拟地址 0x%x, 大小 %d, 值 0x%x\n", addr, size, value);
 
-    exception = Translate(addr, &physicalAddress, size, TRUE);
-    if (exception != NoException) {
-	machine->RaiseException(exception, addr);
-	return FALSE;
+	exception = Translate(addr, &physicalAddress, size, TRUE);
+	if (exception != NoException) {
+	    machine->RaiseException(exception, addr);
+	    return FALSE;
+	}
+	host = &mainMemory[physicalAddress];
     }
     switch (size) {
       case 1:
-	machine->mainMemory[physicalAddress] = (unsigned char) (value & 0xff);
+	*host = (unsigned char) (value & 0xff);
 	break;
 
       case 2:
-	*(unsigned short *) &machine->mainMemory[physicalAddress]
+	*(unsigned short *) host
 		= ShortToMachine((unsigned short) (value & 0xffff));
 	break;
       
       case 4:
-	*(unsigned int *) &machine->mainMemory[physicalAddress]
+	*(unsigned int *) host
 		= WordToMachine((unsigned int) value);
 	break;
 	
@@ -137,6 +152,35 @@ Machine::WriteMem(int addr, int size, int value)
     return TRUE;
 }
 
+//----------------------------------------------------------------------
+// Machine::HostAddress
+// 	在主机页缓存中查找 "virtAddr"（见 machine.h）。
+//	读访问总是返回 NULL，走 Translate，以便把每次读取的页
+//	记录到 pages.txt；只有写访问使用快速路径。
+//----------------------------------------------------------------------
+
+char *
+Machine::HostAddress(int virtAddr, bool writing)
+{
+    unsigned int vpn = (unsigned) virtAddr / PageSize;
+    HostPageEntry *cached = &hostPages[vpn % HostPageCacheSize];
+    TranslationEntry *entry = cached->entry;
+
+    if (!writing)
+	return NULL;
+    if (cached->virtualPage != (int) vpn || cached->table != pageTable
+	    || vpn >= pageTableSize || !entry->valid
+	    || entry->physicalPage != cached->frame || entry->readOnly)
+	return NULL;
+    if (tlb != NULL && !tlb->Touch(cached->slot, vpn, asid, entry))
+	return NULL;
+    entry->use = TRUE;
+    entry->dirty = TRUE;
+    if (refRecorder != NULL)
+	refRecorder->Record(vpn, TRUE);
+    return cached->host + (unsigned) virtAddr % PageSize;
+}
+
 //----------------------------------------------------------------------
 // Machine::Translate
 // 	将虚拟地址转换为物理地址，使用 
@@ -153,10 +197,10 @@ Machine::WriteMem(int addr, int size, int value)
 ExceptionType
 Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 {
-    int i;
     unsigned int vpn, offset;
     TranslationEntry *entry;
     unsigned int pageFrame;
+    HostPageEntry *cached;
 
     DEBUG('a', "\t转换 0x%x, %s: ", virtAddr, writing ? "写入" : "读取");
 
@@ -166,9 +210,8 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 	return AddressErrorException;
     }
     
-    // 我们必须有 TLB 或页表，但不能同时有两者！
-    ASSERT(tlb == NULL || pageTable == NULL);	
-    ASSERT(tlb != NULL || pageTable != NULL);	
+    // 页表总是需要的；TLB 只是页表的缓存，未命中时由硬件查找页表
+    ASSERT(pageTable != NULL);	
 
 // 从虚拟地址计算虚拟页号和页内偏移
     vpn = (unsigned) virtAddr / PageSize;
@@ -183,7 +226,8 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 		fprintf(file, "%d\n", vpn);
 		fclose(file);
 	}
-    if (tlb == NULL) {		// => 页表 => vpn 是表中的索引
+    if (tlb == NULL || (entry = tlb->Lookup(vpn, asid)) == NULL) {
+				// 无 TLB 或 TLB 未命中 => 查页表 => vpn 是表中的索引
 	if (vpn >= pageTableSize) {
 	    DEBUG('a', "虚拟页号 %d 超过页表大小 %d!\n", 
 			virtAddr, pageTableSize);
@@ -194,22 +238,12 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 	    return PageFaultException;
 	}
 	entry = &pageTable[vpn];
-    } else {
-        for (entry = NULL, i = 0; i < TLBSize; i++)
-    	    if (tlb[i].valid && ((unsigned int)tlb[i].virtualPage == vpn)) {
-		entry = &tlb[i];			// 找到！
-		break;
-	    }
-	if (entry == NULL) {				// 未找到
-    	    DEBUG('a', "*** 未找到此虚拟页的有效 TLB 条目!\n");
-    	    return PageFaultException;		// 实际上，这是一个 TLB 故障，
-						// 页可能在内存中，
-						// 但不在 TLB 中
-	}
+	if (tlb != NULL)
+	    tlb->Insert(vpn, asid, entry);	// 装入 TLB，可能替换一项
     }
 
     if (entry->readOnly && writing) {	// 尝试写入只读页
-	DEBUG('a', "%d 在 TLB 中映射为只读的 %d!\n", virtAddr, i);
+	DEBUG('a', "%d 映射为只读!\n", virtAddr);
 	return ReadOnlyException;
     }
     pageFrame = entry->physicalPage;
@@ -225,6 +259,16 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 	entry->dirty = TRUE;
     *physAddr = pageFrame * PageSize + offset;
     ASSERT((*physAddr >= 0) && ((*physAddr + size) <= MemorySize));
+
+    cached = &hostPages[vpn % HostPageCacheSize];	// 记入主机页缓存
+    cached->virtualPage = vpn;
+    cached->table = pageTable;
+    cached->entry = entry;
+    cached->frame = pageFrame;
+    cached->slot = (tlb != NULL) ? tlb->LastSlot() : NULL;
+    cached->host = &mainMemory[pageFrame * PageSize];
+    if (refRecorder != NULL)
+	refRecorder->Record(vpn, writing);
     DEBUG('a', "物理地址 = 0x%x\n", *physAddr);
     return NoException;
 }
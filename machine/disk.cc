@@ -6,6 +6,9 @@
 //	磁盘操作是异步的，因此我们必须在模拟操作完成时
 //	调用中断处理程序。
 //
+//	也可以把整个UNIX文件映射到内存（见 Disk::MapImage），
+//	此时对磁盘的读写变成对映像的内存复制。
+//
 //  请勿更改 -- 机器仿真的一部分
 //
 
@@ -15,10 +18,16 @@
 // 我们将其放在表示磁盘的UNIX文件的前面，
 // 以减少意外将有用文件视为磁盘的可能性
 // （这可能会破坏文件的内容）。
+//
+// 旧的映像只有 MagicNumber，几何参数为默认值；新的映像以
+// GeometryMagic 开头，后面依次是扇区大小、每轨扇区数和轨道数。
 #define MagicNumber 0x456789ab
+#define GeometryMagic 0x456789ac
 #define MagicSize sizeof(int)
+#define GeometrySize (4 * sizeof(int))
 
-#define DiskSize (MagicSize + (NumSectors * SectorSize))
+int sectorsPerTrack = DefaultSectorsPerTrack;
+int numTracks = DefaultNumTracks;
 
 // 虚拟过程，因为我们不能获取成员函数的指针
 static void DiskDone(_int arg) { ((Disk *)arg)->HandleInterrupt(); }
@@ -31,11 +40,14 @@ static void DiskDone(_int arg) { ((Disk *)arg)->HandleInterrupt(); }
 //	"name" -- 模拟Nachos磁盘的文件的文本名称
 //	"callWhenDone" -- 磁盘读/写请求完成时调用的中断处理程序
 //	"callArg" -- 传递给中断处理程序的参数
+//	"tracks", "trackSectors" -- 大于 0 时按此几何参数重新创建磁盘
 //----------------------------------------------------------------------
 
-Disk::Disk(const char *name, VoidFunctionPtr callWhenDone, _int callArg)
+Disk::Disk(const char *name, VoidFunctionPtr callWhenDone, _int callArg,
+           int tracks, int trackSectors)
 {
     int magicNum;
+    int header[GeometrySize / sizeof(int)];
     int tmp = 0;
 
     DEBUG('d', "正在初始化磁盘, 0x%x 0x%x\n", callWhenDone, callArg);
@@ -43,36 +55,94 @@ Disk::Disk(const char *name, VoidFunctionPtr callWhenDone, _int callArg)
     handlerArg = callArg;
     lastSector = 0;
     bufferInit = 0;
+    image = NULL;
 
-    fileno = OpenForReadWrite((char *)name, FALSE);
+    fileno = -1;
+    if (tracks <= 0)
+        fileno = OpenForReadWrite((char *)name, FALSE);
     if (fileno >= 0)
-    { // 文件存在，检查魔术数字
+    { // 文件存在，检查魔术数字并读出几何参数
         Read(fileno, (char *)&magicNum, MagicSize);
-        ASSERT(magicNum == MagicNumber);
+        if (magicNum == MagicNumber)
+        { // 旧的映像
+            headerSize = MagicSize;
+            sectorsPerTrack = DefaultSectorsPerTrack;
+            numTracks = DefaultNumTracks;
+        }
+        else
+        {
+            ASSERT(magicNum == GeometryMagic);
+            Read(fileno, (char *)&header[1], GeometrySize - MagicSize);
+            ASSERT(header[1] == SectorSize); // 扇区大小在编译时固定
+            ASSERT((header[2] > 0) && (header[3] > 0));
+            headerSize = GeometrySize;
+            sectorsPerTrack = header[2];
+            numTracks = header[3];
+        }
     }
     else
-    { // 文件不存在，创建它
+    { // 文件不存在或要求新的几何参数，创建它
+        if (tracks > 0)
+        {
+            ASSERT(trackSectors > 0);
+            numTracks = tracks;
+            sectorsPerTrack = trackSectors;
+        }
         fileno = OpenForWrite((char *)name);
-        magicNum = MagicNumber;
-        WriteFile(fileno, (char *)&magicNum, MagicSize); // 写入魔术数字
+        header[0] = GeometryMagic;
+        header[1] = SectorSize;
+        header[2] = sectorsPerTrack;
+        header[3] = numTracks;
+        headerSize = GeometrySize;
+        WriteFile(fileno, (char *)header, GeometrySize); // 写入魔术数字和几何参数
 
         // 需要在文件末尾写入，以便读取不会返回EOF
-        Lseek(fileno, DiskSize - sizeof(int), 0);
+        Lseek(fileno, headerSize + NumSectors * SectorSize - sizeof(int), 0);
         WriteFile(fileno, (char *)&tmp, sizeof(int));
     }
+    imageSize = headerSize + NumSectors * SectorSize;
+    DEBUG('d', "磁盘几何参数: %d 个轨道, 每轨 %d 个扇区\n", numTracks,
+          sectorsPerTrack);
     active = FALSE;
 }
 
 //----------------------------------------------------------------------
 // Disk::~Disk()
 // 	通过关闭表示磁盘的UNIX文件来清理磁盘模拟。
+//	映像映射到内存时，除非写回策略为 none，先等待
+//	所有修改写回文件。
 //----------------------------------------------------------------------
 
 Disk::~Disk()
 {
+    if (image != NULL)
+    {
+        if (syncPolicy != DiskSyncNone)
+            SyncMappedFile(image, imageSize, TRUE);
+        UnmapFile(image, imageSize);
+    }
     Close(fileno);
 }
 
+//----------------------------------------------------------------------
+// Disk::MapImage()
+// 	把表示磁盘的UNIX文件整个映射到内存。此后的读写请求
+//	直接复制映像中的扇区，不再为每个请求调用 lseek/read/write；
+//	请求的模拟时间与不映射时完全相同。应在发出任何请求之前调用。
+//
+//	"sync" -- 何时把映像中的修改主动写回文件
+//----------------------------------------------------------------------
+
+void Disk::MapImage(DiskSyncPolicy sync)
+{
+    ASSERT(image == NULL);
+    Lseek(fileno, 0, 2);
+    ASSERT(Tell(fileno) >= imageSize); // 映射超出文件的部分无法访问
+    image = MapFile(fileno, imageSize);
+    syncPolicy = sync;
+    lastSync = stats->totalTicks;
+}
+
 //----------------------------------------------------------------------
 // Disk::PrintSector()
 // 	转储磁盘读/写请求中的数据，用于调试。
@@ -108,39 +178,86 @@ PrintSector(bool writing, int sector, char *data)
 
 void Disk::ReadRequest(int sectorNumber, char *data)
 {
-    int ticks = ComputeLatency(sectorNumber, FALSE);
+    ReadRequestV(sectorNumber, 1, &data);
+}
 
-    ASSERT(!active); // 一次只能有一个请求
-    ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
+void Disk::WriteRequest(int sectorNumber, char *data)
+{
+    WriteRequestV(sectorNumber, 1, &data);
+}
+
+//----------------------------------------------------------------------
+// Disk::ReadRequestV/WriteRequestV
+// 	模拟对连续若干个磁盘扇区的读/写请求。与单个扇区的
+//	请求一样立即对UNIX文件进行读/写（一次 preadv/pwritev），
+//	并在模拟的整个传输完成时产生一次中断。
+//
+//	"firstSector" -- 要读/写的第一个磁盘扇区
+//	"numSectors" -- 扇区数
+//	"data" -- 每个扇区一个缓冲区，保存要写入或读入的字节
+//----------------------------------------------------------------------
 
-    DEBUG('d', "从扇区 %d 读取\n", sectorNumber);
-    Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
-    Read(fileno, data, SectorSize);
+void Disk::ReadRequestV(int firstSector, int numSectors, char **data)
+{
+    int ticks = ComputeLatency(firstSector, FALSE, numSectors);
+
+    ASSERT(!active); // 一次只能有一个请求
+    ASSERT((firstSector >= 0) && (numSectors > 0) &&
+           (firstSector + numSectors <= NumSectors));
+
+    DEBUG('d', "从扇区 %d 读取 %d 个扇区\n", firstSector, numSectors);
+    if (image != NULL)
+        for (int i = 0; i < numSectors; i++)
+            bcopy(&image[SectorSize * (firstSector + i) + headerSize], data[i],
+                  SectorSize);
+    else
+        ReadVector(fileno, data, numSectors, SectorSize,
+                   SectorSize * firstSector + headerSize);
     if (DebugIsEnabled('d'))
-        PrintSector(FALSE, sectorNumber, data);
+        for (int i = 0; i < numSectors; i++)
+            PrintSector(FALSE, firstSector + i, data[i]);
 
     active = TRUE;
-    UpdateLast(sectorNumber);
+    stats->numDiskTracksMoved += TracksMoved(firstSector, numSectors);
+    UpdateLast(firstSector + numSectors - 1);
     stats->numDiskReads++;
+    stats->numDiskSectorsRead += numSectors;
     interrupt->Schedule(DiskDone, (_int)this, ticks, DiskInt);
 }
 
-void Disk::WriteRequest(int sectorNumber, char *data)
+void Disk::WriteRequestV(int firstSector, int numSectors, char **data)
 {
-    int ticks = ComputeLatency(sectorNumber, TRUE);
+    int ticks = ComputeLatency(firstSector, TRUE, numSectors);
 
     ASSERT(!active);
-    ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
+    ASSERT((firstSector >= 0) && (numSectors > 0) &&
+           (firstSector + numSectors <= NumSectors));
 
-    DEBUG('d', "写入扇区 %d\n", sectorNumber);
-    Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
-    WriteFile(fileno, data, SectorSize);
+    DEBUG('d', "写入从扇区 %d 开始的 %d 个扇区\n", firstSector, numSectors);
+    if (image != NULL)
+    {
+        for (int i = 0; i < numSectors; i++)
+            bcopy(data[i], &image[SectorSize * (firstSector + i) + headerSize],
+                  SectorSize);
+        if ((syncPolicy == DiskSyncPeriodic) &&
+            (stats->totalTicks - lastSync >= DiskSyncTicks))
+        {
+            SyncMappedFile(image, imageSize, FALSE);
+            lastSync = stats->totalTicks;
+        }
+    }
+    else
+        WriteVector(fileno, data, numSectors, SectorSize,
+                    SectorSize * firstSector + headerSize);
     if (DebugIsEnabled('d'))
-        PrintSector(TRUE, sectorNumber, data);
+        for (int i = 0; i < numSectors; i++)
+            PrintSector(TRUE, firstSector + i, data[i]);
 
     active = TRUE;
-    UpdateLast(sectorNumber);
+    stats->numDiskTracksMoved += TracksMoved(firstSector, numSectors);
+    UpdateLast(firstSector + numSectors - 1);
     stats->numDiskWrites++;
+    stats->numDiskSectorsWritten += numSectors;
     interrupt->Schedule(DiskDone, (_int)this, ticks, DiskInt);
 }
 
@@ -168,8 +285,8 @@ void Disk::HandleInterrupt()
 
 int Disk::TimeToSeek(int newSector, int *rotation)
 {
-    int newTrack = newSector / SectorsPerTrack;
-    int oldTrack = lastSector / SectorsPerTrack;
+    int newTrack = newSector / sectorsPerTrack;
+    int oldTrack = lastSector / sectorsPerTrack;
     int seek = abs(newTrack - oldTrack) * SeekTime;
     // 寻道需要多长时间？
     int over = (stats->totalTicks + seek) % RotationTime;
@@ -181,6 +298,20 @@ int Disk::TimeToSeek(int newSector, int *rotation)
     return seek;
 }
 
+//----------------------------------------------------------------------
+// Disk::TracksMoved()
+// 	返回从当前磁头位置开始，完成对从 newSector 开始的
+//	numSectors 个扇区的请求，磁头要经过多少个轨道。
+//----------------------------------------------------------------------
+
+int Disk::TracksMoved(int newSector, int numSectors)
+{
+    int newTrack = newSector / sectorsPerTrack;
+    int lastTrack = (newSector + numSectors - 1) / sectorsPerTrack;
+
+    return abs(newTrack - lastSector / sectorsPerTrack) + (lastTrack - newTrack);
+}
+
 //----------------------------------------------------------------------
 // Disk::ModuloDiff()
 // 	返回目标扇区"to"和当前扇区位置"from"之间的旋转延迟扇区数
@@ -188,10 +319,10 @@ int Disk::TimeToSeek(int newSector, int *rotation)
 
 int Disk::ModuloDiff(int to, int from)
 {
-    int toOffset = to % SectorsPerTrack;
-    int fromOffset = from % SectorsPerTrack;
+    int toOffset = to % sectorsPerTrack;
+    int fromOffset = from % sectorsPerTrack;
 
-    return ((toOffset - fromOffset) + SectorsPerTrack) % SectorsPerTrack;
+    return ((toOffset - fromOffset) + sectorsPerTrack) % sectorsPerTrack;
 }
 
 //----------------------------------------------------------------------
@@ -208,27 +339,35 @@ int Disk::ModuloDiff(int to, int from)
 //   	磁盘还有一个“轨道缓冲区”；磁盘不断将当前磁盘轨道的内容读取到缓冲区中。
 //   	这使得对当前轨道的读取请求能够更快地满足。
 //   	轨道缓冲区的内容在每次寻道到新轨道后被丢弃。
+//
+//   	多扇区请求只对第一个扇区计算寻道和旋转延迟，之后的
+//   	扇区紧接着从磁头下经过，每个只需一个RotationTime的
+//   	传输时间；每跨过一个轨道边界再加一次单轨道寻道。
 //----------------------------------------------------------------------
 
-int Disk::ComputeLatency(int newSector, bool writing)
+int Disk::ComputeLatency(int newSector, bool writing, int numSectors)
 {
     int rotation;
     int seek = TimeToSeek(newSector, &rotation);
     int timeAfter = stats->totalTicks + seek + rotation;
+    int lastTrack = (newSector + numSectors - 1) / sectorsPerTrack;
+    int rest = (numSectors - 1) * RotationTime +
+               (lastTrack - newSector / sectorsPerTrack) * SeekTime;
+                                // 第一个扇区之后的传输时间
 
 #ifndef NOTRACKBUF // 如果您不想要轨道缓冲区的内容，请打开此选项
     // 检查轨道缓冲区是否适用
     if ((writing == FALSE) && (seek == 0) && (((timeAfter - bufferInit) / RotationTime) > ModuloDiff(newSector, bufferInit / RotationTime)))
     {
-        DEBUG('d', "请求延迟 = %d\n", RotationTime);
-        return RotationTime; // 从轨道缓冲区传输扇区的时间
+        DEBUG('d', "请求延迟 = %d\n", RotationTime + rest);
+        return RotationTime + rest; // 从轨道缓冲区传输扇区的时间
     }
 #endif
 
     rotation += ModuloDiff(newSector, timeAfter / RotationTime) * RotationTime;
 
-    DEBUG('d', "请求延迟 = %d\n", seek + rotation + RotationTime);
-    return (seek + rotation + RotationTime);
+    DEBUG('d', "请求延迟 = %d\n", seek + rotation + RotationTime + rest);
+    return (seek + rotation + RotationTime + rest);
 }
 
 //----------------------------------------------------------------------
@@ -39,19 +39,42 @@
 // 因为其内容在轨道缓冲区中。如今大多数磁盘都配备了轨道缓冲区。
 //
 // 通过使用 -DNOTRACKBUF 编译可以禁用轨道缓冲区模拟
+//
+// 磁盘的几何参数（轨道数、每轨扇区数）在创建磁盘映像时确定，
+// 记录在映像开头的头部中，打开已有的映像时从头部读出。
+// 扇区大小决定了页面大小和文件头的布局，仍然在编译时固定，
+// 头部中记录的扇区大小必须与之相同。
 
 #define SectorSize 128     // 每个磁盘扇区的字节数
-#define SectorsPerTrack 32 // 每个磁盘轨道的扇区数
-#define NumTracks 32       // 每个磁盘的轨道数
-#define NumSectors (SectorsPerTrack * NumTracks)
+#define DefaultSectorsPerTrack 32 // 新建磁盘映像时默认的几何参数
+#define DefaultNumTracks 32
+
+extern int sectorsPerTrack; // 每个磁盘轨道的扇区数
+extern int numTracks;       // 每个磁盘的轨道数
+#define NumSectors (sectorsPerTrack * numTracks)
 // 磁盘的总扇区数
 
+// 把磁盘映像映射到内存时（见 Disk::MapImage），何时用 msync
+// 把修改写回 UNIX 文件。不论哪种策略，修改都会由宿主机
+// 在之后的某个时间写回；这里只决定是否以及何时主动写回。
+enum DiskSyncPolicy
+{
+  DiskSyncNone,    // 从不主动写回
+  DiskSyncHalt,    // 在磁盘被释放（系统停止）时写回
+  DiskSyncPeriodic // 另外每隔 DiskSyncTicks 个时钟周期写回一次
+};
+
+#define DiskSyncTicks 100000 // periodic 策略下两次写回的最短间隔
+
 class Disk
 {
 public:
-  Disk(const char *name, VoidFunctionPtr callWhenDone, _int callArg);
+  Disk(const char *name, VoidFunctionPtr callWhenDone, _int callArg,
+       int tracks = 0, int trackSectors = 0);
   // 创建一个模拟磁盘。
   // 每次请求完成时调用 (*callWhenDone)(callArg)
+  // tracks 大于 0 时以 tracks * trackSectors 的几何参数
+  // 重新创建磁盘映像，原有内容被丢弃
   ~Disk(); // 释放磁盘。
 
   void ReadRequest(int sectorNumber, char *data);
@@ -60,12 +83,22 @@ public:
   // 仅允许一个请求同时进行！
   void WriteRequest(int sectorNumber, char *data);
 
+  void ReadRequestV(int firstSector, int numSectors, char **data);
+  void WriteRequestV(int firstSector, int numSectors, char **data);
+  // 读取/写入从 firstSector 开始的连续 numSectors 个扇区，
+  // data[i] 是第 i 个扇区的缓冲区。整个请求只寻道
+  // 一次，完成时只产生一次中断。
+
+  void MapImage(DiskSyncPolicy sync);
+  // 把整个磁盘映像映射到内存，此后的读写
+  // 变成内存复制，模拟的延迟不变
+
   void HandleInterrupt(); // 中断处理程序，当
                           // 磁盘请求完成时调用。
 
-  int ComputeLatency(int newSector, bool writing);
-  // 返回对新扇区的请求将花费多长时间：
-  // （寻道 + 旋转延迟 + 传输）
+  int ComputeLatency(int newSector, bool writing, int numSectors = 1);
+  // 返回对从新扇区开始的 numSectors 个扇区的请求
+  // 将花费多长时间：（寻道 + 旋转延迟 + 传输）
 
 private:
   int fileno;              // 模拟磁盘的UNIX文件号
@@ -74,9 +107,15 @@ private:
   bool active;             // 磁盘操作是否正在进行？
   int lastSector;          // 上一个磁盘请求
   int bufferInit;          // 轨道缓冲区开始加载的时间
+  int headerSize;          // 映像开头的头部的字节数
+  int imageSize;           // 整个映像的字节数
+  char *image;             // 映射到内存的磁盘映像，未映射时为 NULL
+  DiskSyncPolicy syncPolicy; // 映射时的写回策略
+  int lastSync;            // 上一次写回映像的时间
 
   int TimeToSeek(int newSector, int *rotate); // 到达新轨道的时间
   int ModuloDiff(int to, int from);           // 到和从之间的扇区数
+  int TracksMoved(int newSector, int numSectors); // 请求经过的轨道数
   void UpdateLast(int newSector);
 };
 
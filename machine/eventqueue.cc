@@ -0,0 +1,183 @@
+// eventqueue.cc
+//	按 (键, 插入序号) 排序的二叉堆，用于模拟的中断队列。
+//	参见 eventqueue.h。
+//
+//  请勿更改 -- 机器仿真的一部分
+//
+
+#include "eventqueue.h"
+
+#define InitialCapacity 16	// heap 数组的初始大小
+
+//----------------------------------------------------------------------
+// EventQueue::EventQueue
+//	初始化一个空队列。
+//----------------------------------------------------------------------
+
+EventQueue::EventQueue()
+{
+    heap = new EventQueueEntry[InitialCapacity];
+    capacity = InitialCapacity;
+    numItems = 0;
+    nextSeq = 0;
+}
+
+//----------------------------------------------------------------------
+// EventQueue::~EventQueue
+//	释放队列。与 List 一样，不释放队列中的项目本身。
+//----------------------------------------------------------------------
+
+EventQueue::~EventQueue()
+{
+    delete [] heap;
+}
+
+//----------------------------------------------------------------------
+// EventQueue::Before
+//	如果 "a" 应在 "b" 之前取出则返回 TRUE：键较小者在前，
+//	键相同时先插入者在前。
+//----------------------------------------------------------------------
+
+bool
+EventQueue::Before(EventQueueEntry *a, EventQueueEntry *b)
+{
+    if (a->key != b->key)
+        return (a->key < b->key);
+    return (a->seq < b->seq);
+}
+
+//----------------------------------------------------------------------
+// EventQueue::SiftUp
+//	把位置 "i" 上的项目向上移动，直到它不早于其父节点。
+//----------------------------------------------------------------------
+
+void
+EventQueue::SiftUp(int i)
+{
+    EventQueueEntry entry = heap[i];
+    int parent;
+
+    while (i > 0) {
+        parent = (i - 1) / 2;
+        if (!Before(&entry, &heap[parent]))
+            break;
+        heap[i] = heap[parent];
+        i = parent;
+    }
+    heap[i] = entry;
+}
+
+//----------------------------------------------------------------------
+// EventQueue::SiftDown
+//	把位置 "i" 上的项目向下移动，直到它不晚于其子节点。
+//----------------------------------------------------------------------
+
+void
+EventQueue::SiftDown(int i)
+{
+    EventQueueEntry entry = heap[i];
+    int child;
+
+    while ((child = 2 * i + 1) < numItems) {
+        if (child + 1 < numItems && Before(&heap[child + 1], &heap[child]))
+            child++;			// 选较早的子节点
+        if (!Before(&heap[child], &entry))
+            break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = entry;
+}
+
+//----------------------------------------------------------------------
+// EventQueue::Insert
+//	按 "sortKey" 放入 "item"。数组满时容量加倍。
+//
+//	"item" 是要放入队列的东西，可以是指向任何事物的指针。
+//	"sortKey" 是项目的优先级。
+//----------------------------------------------------------------------
+
+void
+EventQueue::Insert(void *item, int sortKey)
+{
+    if (numItems == capacity) {
+        EventQueueEntry *bigger = new EventQueueEntry[capacity * 2];
+
+        for (int i = 0; i < numItems; i++)
+            bigger[i] = heap[i];
+        delete [] heap;
+        heap = bigger;
+        capacity *= 2;
+    }
+    heap[numItems].key = sortKey;
+    heap[numItems].seq = nextSeq++;
+    heap[numItems].item = item;
+    numItems++;
+    SiftUp(numItems - 1);
+}
+
+//----------------------------------------------------------------------
+// EventQueue::Peek
+//	返回最早的项目但不取出，队列为空时返回 NULL。
+//	如果 "keyPtr" 不为 NULL，将 *keyPtr 设置为该项目的键。
+//----------------------------------------------------------------------
+
+void *
+EventQueue::Peek(int *keyPtr)
+{
+    if (numItems == 0)
+        return NULL;
+    if (keyPtr != NULL)
+        *keyPtr = heap[0].key;
+    return heap[0].item;
+}
+
+//----------------------------------------------------------------------
+// EventQueue::RemoveMin
+//	取出最早的项目，队列为空时返回 NULL。
+//	如果 "keyPtr" 不为 NULL，将 *keyPtr 设置为该项目的键。
+//----------------------------------------------------------------------
+
+void *
+EventQueue::RemoveMin(int *keyPtr)
+{
+    void *item;
+
+    if (numItems == 0)
+        return NULL;
+    item = heap[0].item;
+    if (keyPtr != NULL)
+        *keyPtr = heap[0].key;
+    numItems--;
+    if (numItems > 0) {
+        heap[0] = heap[numItems];
+        SiftDown(0);
+    }
+    return item;
+}
+
+//----------------------------------------------------------------------
+// EventQueue::Mapcar
+//	按取出的顺序对每个项目调用 "func"。
+//
+//	堆本身是无序的，因此先复制一份再排序；只用于调试输出，
+//	不在乎效率。
+//----------------------------------------------------------------------
+
+void
+EventQueue::Mapcar(VoidFunctionPtr func)
+{
+    EventQueueEntry *sorted = new EventQueueEntry[numItems + 1];
+    EventQueueEntry entry;
+    int i, j;
+
+    for (i = 0; i < numItems; i++) {		// 插入排序
+        entry = heap[i];
+        for (j = i; j > 0 && Before(&entry, &sorted[j - 1]); j--)
+            sorted[j] = sorted[j - 1];
+        sorted[j] = entry;
+    }
+    for (i = 0; i < numItems; i++)
+        (*func)((_int)sorted[i].item);
+    delete [] sorted;
+}
@@ -0,0 +1,54 @@
+// eventqueue.h
+//	用于保存计划在未来发生的中断的优先队列。
+//
+//	与排序链表（List::SortedInsert）相比，插入和取出最早的
+//	项目都是 O(log n)，并且不必为每个项目分配一个 ListElement：
+//	项目保存在一个按需倍增的数组中构成的二叉堆里。
+//
+//	键相同的项目按插入的先后次序取出（与 List::SortedInsert
+//	的顺序相同）：每个项目带有一个递增的序号，堆按 (键, 序号) 排序。
+//
+//  请勿更改 -- 机器仿真的一部分
+//
+
+#ifndef EVENTQUEUE_H
+#define EVENTQUEUE_H
+
+#include "utility.h"
+
+// 堆中的一项：键和序号直接存放在数组中，比较时无需访问项目本身
+
+class EventQueueEntry {
+  public:
+    int key;			// 优先级（中断发生的时间）
+    unsigned int seq;		// 插入序号，用于键相同时保持先进先出
+    void *item;			// 队列中的项目
+};
+
+class EventQueue {
+  public:
+    EventQueue();			// 初始化队列
+    ~EventQueue();			// 释放队列（不释放项目本身）
+
+    void Insert(void *item, int sortKey);	// 按键放入项目
+    void *Peek(int *keyPtr);		// 返回键最小的项目，但不取出
+    void *RemoveMin(int *keyPtr);	// 取出键最小的项目
+    bool IsEmpty() { return (numItems == 0); }
+    int NumItems() { return numItems; }
+
+    void Mapcar(VoidFunctionPtr func);	// 按 (键, 序号) 顺序对每个项目
+					// 调用 "func"（用于调试输出）
+
+  private:
+    EventQueueEntry *heap;	// 二叉堆，heap[0] 是最早的项目
+    int numItems;		// 队列中的项目数
+    int capacity;		// heap 数组的大小
+    unsigned int nextSeq;	// 下一个插入序号
+
+    bool Before(EventQueueEntry *a, EventQueueEntry *b);
+					// a 是否应在 b 之前取出
+    void SiftUp(int i);		// 恢复堆的性质
+    void SiftDown(int i);
+};
+
+#endif // EVENTQUEUE_H
@@ -43,6 +43,7 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, _int param, int time,
     arg = param;
     when = time;
     type = kind;
+    next = NULL;
 }
 
 //----------------------------------------------------------------------
@@ -55,10 +56,13 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, _int param, int time,
 Interrupt::Interrupt()
 {
     level = IntOff;
-    pending = new List();
+    pending = new EventQueue();
+    freeList = NULL;
     inHandler = FALSE;
     yieldOnReturn = FALSE;
     status = SystemMode;
+    nextDue = NoPendingTime;
+    traceTicks = DebugIsEnabled('i');
 }
 
 //----------------------------------------------------------------------
@@ -68,9 +72,17 @@ Interrupt::Interrupt()
 
 Interrupt::~Interrupt()
 {
-    while (!pending->IsEmpty())
-        delete (ListElement *)(pending->Remove());
+    PendingInterrupt *toOccur;
+
+    while ((toOccur = (PendingInterrupt *)pending->RemoveMin(NULL)) != NULL)
+        delete toOccur;
     delete pending;
+    while (freeList != NULL)
+    {
+        toOccur = freeList;
+        freeList = toOccur->next;
+        delete toOccur;
+    }
 }
 
 //----------------------------------------------------------------------
@@ -139,22 +151,29 @@ void Interrupt::Enable()
 //	两件事情可以导致 OneTick 被调用：
 //		中断被重新启用
 //		执行用户指令
+//
+//	"count" -- 推进的时钟数；基本块翻译模式在执行完
+//		一个块后一次性结算块中所有指令的时钟
 //----------------------------------------------------------------------
-void Interrupt::OneTick()
+void Interrupt::OneTick(int count)
 {
     MachineStatus old = status;
 
     // 推进模拟时间
     if (status == SystemMode)
     {
-        stats->totalTicks += SystemTick;
-        stats->systemTicks += SystemTick;
+        stats->totalTicks += SystemTick * count;
+        stats->systemTicks += SystemTick * count;
     }
     else
     { // USER_PROGRAM
-        stats->totalTicks += UserTick;
-        stats->userTicks += UserTick;
+        stats->totalTicks += UserTick * count;
+        stats->userTicks += UserTick * count;
     }
+
+    // 下一个待处理中断到期之前，不必检查待处理列表
+    if (stats->totalTicks < nextDue && !yieldOnReturn && !traceTicks)
+        return;
     DEBUG('i', "\n== 时钟 %d ==\n", stats->totalTicks);
 
     // 检查任何待处理的中断是否现在准备好触发
@@ -174,6 +193,21 @@ void Interrupt::OneTick()
     }
 }
 
+//----------------------------------------------------------------------
+// Interrupt::TicksUntilDue
+// 	返回距离最早的待处理中断到期还有多少个时钟（至少为1）。
+//	在此之前 OneTick 不会触发任何中断，因此 Machine::Run
+//	可以连续执行一批指令后再一次性推进时间。
+//	打开 'i' 调试时每个时钟都要打印，返回1。
+//----------------------------------------------------------------------
+
+int Interrupt::TicksUntilDue()
+{
+    if (traceTicks || nextDue <= stats->totalTicks)
+        return 1;
+    return nextDue - stats->totalTicks;
+}
+
 //----------------------------------------------------------------------
 // Interrupt::YieldOnReturn
 // 	在中断处理程序内部调用，以导致上下文切换
@@ -256,13 +290,27 @@ void Interrupt::Halt()
 void Interrupt::Schedule(VoidFunctionPtr handler, _int arg, int fromNow, IntType type)
 {
     int when = stats->totalTicks + fromNow;
-    PendingInterrupt *toOccur = new PendingInterrupt(handler, arg, when, type);
+    PendingInterrupt *toOccur;
+
+    if (freeList != NULL)
+    { // 重用已触发的中断的节点
+        toOccur = freeList;
+        freeList = toOccur->next;
+        toOccur->handler = handler;
+        toOccur->arg = arg;
+        toOccur->when = when;
+        toOccur->type = type;
+    }
+    else
+        toOccur = new PendingInterrupt(handler, arg, when, type);
 
     DEBUG('i', "调度中断处理程序 %s 在时间 = %d\n",
           intTypeNames[type], when);
     ASSERT(fromNow > 0);
 
-    pending->SortedInsert(toOccur, when);
+    pending->Insert(toOccur, when);
+    if (when < nextDue)
+        nextDue = when;
 }
 
 //----------------------------------------------------------------------
@@ -287,10 +335,13 @@ bool Interrupt::CheckIfDue(bool advanceClock)
     if (DebugIsEnabled('i'))
         DumpState();
     PendingInterrupt *toOccur =
-        (PendingInterrupt *)pending->SortedRemove(&when);
+        (PendingInterrupt *)pending->Peek(&when);
 
     if (toOccur == NULL) // 没有待处理的中断
+    {
+        nextDue = NoPendingTime;
         return FALSE;
+    }
 
     if (advanceClock && when > stats->totalTicks)
     { // 推进时钟
@@ -298,17 +349,18 @@ bool Interrupt::CheckIfDue(bool advanceClock)
         stats->totalTicks = when;
     }
     else if (when > stats->totalTicks)
-    { // 还没到时间，放回去
-        pending->SortedInsert(toOccur, when);
+    { // 还没到时间，留在队列中
+        nextDue = when;
         return FALSE;
     }
 
     // 检查是否没有更多的事情要做，如果是，则退出
-    if ((status == IdleMode) && (toOccur->type == TimerInt) && pending->IsEmpty())
+    if ((status == IdleMode) && (toOccur->type == TimerInt) && (pending->NumItems() == 1))
     {
-        pending->SortedInsert(toOccur, when);
+        nextDue = when;
         return FALSE;
     }
+    pending->RemoveMin(NULL);
 
     DEBUG('i', "在时间 %d 调用 %s 的中断处理程序\n",
           intTypeNames[toOccur->type], toOccur->when);
@@ -316,6 +368,8 @@ bool Interrupt::CheckIfDue(bool advanceClock)
     if (machine != NULL)
         machine->DelayedLoad(0, 0);
 #endif
+    if (!pending->Peek(&nextDue))  // 新的队首；处理程序中
+        nextDue = NoPendingTime;   // 调度的中断由 Schedule 更新
     inHandler = TRUE;
     status = SystemMode;                 // 无论我们在做什么，
                                          // 现在我们将
@@ -323,7 +377,8 @@ bool Interrupt::CheckIfDue(bool advanceClock)
     (*(toOccur->handler))(toOccur->arg); // 调用中断处理程序
     status = old;                        // 恢复机器状态
     inHandler = FALSE;
-    delete toOccur;
+    toOccur->next = freeList; // 节点放回空闲链表
+    freeList = toOccur;
     return TRUE;
 }
 
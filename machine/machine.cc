@@ -43,9 +43,11 @@ void CheckEndian()
 // 	初始化用户程序执行的仿真。
 //
 //	"debug" -- 如果为TRUE，在每条用户指令执行后进入调试器。
+//	"translate" -- 如果为TRUE，以基本块翻译模式执行用户程序
+//		（单步调试时仍使用逐条解释）。
 //----------------------------------------------------------------------
 
-Machine::Machine(bool debug)
+Machine::Machine(bool debug, bool translate)
 {
     int i;
 
@@ -54,16 +56,32 @@ Machine::Machine(bool debug)
     mainMemory = new char[MemorySize];
     for (i = 0; i < MemorySize; i++)
       	mainMemory[i] = 0;
-#ifdef USE_TLB
-    tlb = new TranslationEntry[TLBSize];
-    for (i = 0; i < TLBSize; i++)
-	tlb[i].valid = FALSE;
-    pageTable = NULL;
-#else	// 使用线性页表
+    decodeCache = new Instruction[MemorySize / 4];
+    for (i = 0; i < MemorySize / 4; i++) {	// 内存全为0，预先解码为0
+	decodeCache[i].value = 0;
+	decodeCache[i].Decode();
+    }
     tlb = NULL;
+    asid = 0;
+    stateFile = NULL;
     pageTable = NULL;
+#ifdef USE_TLB
+    tlb = new TLB(TLBSize, TLBSize, TLBLRU);	// 全相联
 #endif
 
+    for (i = 0; i < HostPageCacheSize; i++)
+	hostPages[i].virtualPage = -1;
+    traceMem = DebugIsEnabled('a');
+
+    blockMode = translate;
+    blockCache = NULL;
+    pendingTicks = 0;
+    if (blockMode) {
+	blockCache = new TranslatedBlock *[MemorySize / 4];
+	for (i = 0; i < MemorySize / 4; i++)
+	    blockCache[i] = NULL;
+    }
+
     singleStep = debug;
     CheckEndian();
 }
@@ -75,9 +93,34 @@ Machine::Machine(bool debug)
 
 Machine::~Machine()
 {
+    if (stateFile != NULL)
+	WriteState(stateFile);
     delete [] mainMemory;
+    delete [] decodeCache;
+    if (blockCache != NULL) {
+	for (int i = 0; i < MemorySize / 4; i++)
+	    delete blockCache[i];
+	delete [] blockCache;
+    }
+    if (tlb != NULL)
+        delete tlb;
+}
+
+//----------------------------------------------------------------------
+// Machine::UseTLB
+// 	启用（或替换）TLB。在启动时根据 -tlb 选项调用。
+//
+//	"numEntries" -- TLB 的总项数
+//	"ways" -- 每组的项数（相联度），必须整除 numEntries
+//	"policy" -- 组满时的替换策略
+//----------------------------------------------------------------------
+
+void
+Machine::UseTLB(int numEntries, int ways, TLBPolicy policy)
+{
     if (tlb != NULL)
-        delete [] tlb;
+	delete tlb;
+    tlb = new TLB(numEntries, ways, policy);
 }
 
 //----------------------------------------------------------------------
@@ -96,6 +139,11 @@ Machine::RaiseException(ExceptionType which, int badVAddr)
     DEBUG('m', "异常: %s\n", exceptionNames[which]);
     
 //  ASSERT(interrupt->getStatus() == UserMode);
+    if (pendingTicks > 0) {		// 成批执行时：先结算本批中此前
+	stats->totalTicks += pendingTicks * UserTick;	// 已执行指令的时钟，
+	stats->userTicks += pendingTicks * UserTick;	// 使内核看到的时间
+	pendingTicks = 0;				// 与逐条解释时一致
+    }
     registers[BadVAddrReg] = badVAddr;
     DelayedLoad(0, 0);			// 完成任何正在进行的操作
     interrupt->setStatus(SystemMode);
@@ -147,6 +195,35 @@ void Machine::Debugger()
     delete [] buf;
 }
  
+//----------------------------------------------------------------------
+// Machine::WriteState
+// 	把全部寄存器、用户时钟和主存以文本形式写到文件 "fileName"，
+//	每行一个寄存器或 16 字节内存。用 -dump 选项打开，
+//	test/bbcheck.sh 用它比较解释执行和 -bb 的结果。
+//----------------------------------------------------------------------
+
+void
+Machine::WriteState(char *fileName)
+{
+    FILE *file = fopen(fileName, "w");
+    int i, j;
+
+    if (file == NULL) {
+	printf("无法创建文件 %s\n", fileName);
+	return;
+    }
+    for (i = 0; i < NumTotalRegs; i++)
+	fprintf(file, "r%d 0x%08x\n", i, registers[i]);
+    fprintf(file, "userTicks %d\n", stats->userTicks);
+    for (i = 0; i < MemorySize; i += 16) {
+	fprintf(file, "%06x", i);
+	for (j = 0; j < 16; j++)
+	    fprintf(file, " %02x", (unsigned char) mainMemory[i + j]);
+	fprintf(file, "\n");
+    }
+    fclose(file);
+}
+
 //----------------------------------------------------------------------
 // Machine::DumpState
 // 	打印用户程序的CPU状态。我们可能会打印内存的内容，
@@ -204,3 +281,155 @@ void Machine::WriteRegister(int num, int value)
 	// DEBUG('m', "写入寄存器 %d, 值 %d\n", num, value);
 	registers[num] = value;
     }
+
+//----------------------------------------------------------------------
+// TLB::TLB
+// 	初始化一个空的组相联 TLB。
+//
+//	"numEntries" -- 总项数
+//	"associativity" -- 每组的项数；等于 numEntries 时为全相联，
+//		为 1 时为直接映射
+//	"replacement" -- 组满时的替换策略
+//----------------------------------------------------------------------
+
+TLB::TLB(int numEntries, int associativity, TLBPolicy replacement)
+{
+    ASSERT(numEntries > 0 && associativity > 0);
+    ASSERT(numEntries % associativity == 0);
+    ways = associativity;
+    numSets = numEntries / associativity;
+    policy = replacement;
+    clock = 0;
+    lastSlot = NULL;
+    slots = new TLBSlot[numEntries];
+    FlushAll();
+}
+
+TLB::~TLB()
+{
+    delete [] slots;
+}
+
+//----------------------------------------------------------------------
+// TLB::SetOf
+// 	返回 <vpn, asid> 所在组的第一项。
+//	把 asid 混入散列，使各地址空间的相同虚拟页分散到不同的组。
+//----------------------------------------------------------------------
+
+TLBSlot *
+TLB::SetOf(int vpn, int asid)
+{
+    unsigned int hash = (unsigned int)vpn ^ ((unsigned int)asid * 0x9e3779b1);
+
+    return &slots[(hash % numSets) * ways];
+}
+
+//----------------------------------------------------------------------
+// TLB::Lookup
+// 	在组内查找 <vpn, asid>。命中返回缓存的页表项，否则返回 NULL。
+//	如果缓存的页表项已失效（页被换出），丢弃该项并按未命中处理。
+//----------------------------------------------------------------------
+
+TranslationEntry *
+TLB::Lookup(int vpn, int asid)
+{
+    TLBSlot *set = SetOf(vpn, asid);
+
+    for (int i = 0; i < ways; i++)
+	if (set[i].valid && set[i].virtualPage == vpn && set[i].asid == asid) {
+	    if (!set[i].entry->valid) {
+		set[i].valid = FALSE;
+		break;
+	    }
+	    if (policy == TLBLRU)
+		set[i].stamp = ++clock;
+	    stats->tlbHits[StatSpace(asid)]++;
+	    lastSlot = &set[i];
+	    return set[i].entry;
+	}
+    stats->tlbMisses[StatSpace(asid)]++;
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// TLB::Insert
+// 	装入 <vpn, asid> -> "entry"。组中有空项时使用空项，
+//	否则按替换策略选出一项替换，并记入被替换者的统计。
+//----------------------------------------------------------------------
+
+void
+TLB::Insert(int vpn, int asid, TranslationEntry *entry)
+{
+    TLBSlot *set = SetOf(vpn, asid);
+    TLBSlot *victim = NULL;
+    int i;
+
+    for (i = 0; i < ways && victim == NULL; i++)
+	if (!set[i].valid)
+	    victim = &set[i];
+    if (victim == NULL) {
+	if (policy == TLBRandom)
+	    victim = &set[Random() % ways];
+	else {			// LRU 和 FIFO 都替换时间戳最早的项
+	    victim = &set[0];
+	    for (i = 1; i < ways; i++)
+		if (set[i].stamp < victim->stamp)
+		    victim = &set[i];
+	}
+	stats->tlbEvictions[StatSpace(victim->asid)]++;
+    }
+    victim->valid = TRUE;
+    victim->virtualPage = vpn;
+    victim->asid = asid;
+    victim->entry = entry;
+    victim->stamp = ++clock;
+    lastSlot = victim;
+}
+
+//----------------------------------------------------------------------
+// TLB::Touch
+// 	Machine 的主机页缓存记住了上次翻译所用的 TLB 项；再次使用时
+//	调用本函数确认该项仍然有效（未被替换或清除），并像 Lookup
+//	命中一样更新 LRU 时间戳和统计，从而使两条路径的记账一致。
+//	项已失效时返回 FALSE，调用者应改用完整的翻译。
+//----------------------------------------------------------------------
+
+bool
+TLB::Touch(TLBSlot *slot, int vpn, int asid, TranslationEntry *entry)
+{
+    if (slot == NULL || !slot->valid || slot->virtualPage != vpn
+	    || slot->asid != asid || slot->entry != entry)
+	return FALSE;
+    if (policy == TLBLRU)
+	slot->stamp = ++clock;
+    stats->tlbHits[StatSpace(asid)]++;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// TLB::FlushASID
+// 	清除地址空间 "asid" 的所有项。在地址空间被销毁时调用，
+//	因为这些项指向它的页表。
+//----------------------------------------------------------------------
+
+void
+TLB::FlushASID(int asid)
+{
+    for (int i = 0; i < numSets * ways; i++)
+	if (slots[i].asid == asid)
+	    slots[i].valid = FALSE;
+}
+
+//----------------------------------------------------------------------
+// TLB::FlushAll
+// 	清空 TLB。
+//----------------------------------------------------------------------
+
+void
+TLB::FlushAll()
+{
+    for (int i = 0; i < numSets * ways; i++) {
+	slots[i].valid = FALSE;
+	slots[i].asid = -1;
+    }
+}
@@ -83,6 +83,52 @@ public:
 							  // 立即数是符号扩展的。
 };
 
+// 基本块翻译模式（-bb）使用的数据结构。
+//
+// 一个基本块是从某个物理地址开始、顺序执行的一串指令，
+// 以分支（连同其延迟槽）或系统调用结束，且不跨越物理页。
+// 每条指令被翻译为一个处理函数加上解码后的指令，
+// 执行时依次调用处理函数（线程化代码），整个块的时钟一次性结算。
+
+class Machine;
+typedef bool (*InstrHandler)(Machine *m, Instruction *instr);
+// 执行一条指令；如果陷入内核（异常或系统调用）则返回FALSE
+
+#define MaxBlockLength (PageSize / 4) // 一个块最多占满一页
+
+class BlockEntry
+{
+public:
+	InstrHandler handler; // 执行该指令的处理函数
+	Instruction instr;	  // 解码后的指令（含原始字，用于校验）
+};
+
+class TranslatedBlock
+{
+public:
+	int length; // 块中的指令数
+	BlockEntry entries[MaxBlockLength];
+};
+
+// 主机页缓存：记住最近翻译过的几个虚拟页在 mainMemory 中的主机地址，
+// 使对齐的读写和取指不必每次都完整地走一遍 Translate。
+// 每项记下填入时的页表、页表项、物理页和 TLB 项，使用前逐一核对，
+// 因此内核改写页表项（换出、重新映射、改为只读）、切换页表
+// 或 TLB 替换该项后，缓存项自动失效，无需显式清除。
+
+#define HostPageCacheSize 8 // 直接映射，按虚拟页号索引
+
+class HostPageEntry
+{
+public:
+	int virtualPage;		 // 缓存的虚拟页号，-1 表示空
+	TranslationEntry *table; // 填入时的页表
+	TranslationEntry *entry; // 对应的页表项
+	int frame;				 // 填入时的物理页号
+	TLBSlot *slot;			 // 翻译所用的 TLB 项（无 TLB 时为 NULL）
+	char *host;				 // 该物理页在 mainMemory 中的起始地址
+};
+
 // 以下类定义了用户程序所见的模拟主机工作站硬件，
 // 包括CPU寄存器、主内存等。
 // 用户程序不应该能够分辨它们是在我们的
@@ -99,8 +145,9 @@ public:
 class Machine
 {
 public:
-	Machine(bool debug); // 初始化硬件的仿真
-						 // 以运行用户程序
+	Machine(bool debug, bool translate = FALSE);
+	// 初始化硬件的仿真以运行用户程序；
+	// "translate"为TRUE时以基本块翻译模式执行
 	~Machine(); // 释放数据结构
 
 	// 可由Nachos内核调用的例程
@@ -113,8 +160,22 @@ public:
 
 	// 机器仿真内部的例程 -- 请勿调用这些
 
-	void OneInstruction(Instruction *instr);
-	// 运行用户程序的一条指令。
+	bool OneInstruction();
+	// 运行用户程序的一条指令；陷入内核时返回FALSE。
+	Instruction *FetchInstruction();
+	// 取出PC处的指令，返回预解码缓存中的条目；
+	// 若取指失败（已引发异常）则返回NULL。
+	bool ExecuteInstruction(Instruction *instr);
+	// 执行一条已解码的指令（参考解释器）；
+	// 如果陷入内核则返回FALSE。
+
+	void RunBlocks();
+	// 以基本块翻译模式运行用户程序；永不返回。
+	TranslatedBlock *FindBlock();
+	// 返回从PC开始的已翻译块，必要时（重新）翻译；
+	// 若取指失败（已引发异常）则返回NULL。
+	void TranslateBlock(TranslatedBlock *block, int physAddr);
+	// 将从物理地址"physAddr"开始的指令翻译为一个块
 	void DelayedLoad(int nextReg, int nextVal);
 	// 执行待处理的延迟加载（修改寄存器）
 
@@ -129,12 +190,21 @@ public:
 	// 对齐。适当地设置使用和脏位
 	// 在翻译条目中，
 	// 如果翻译无法完成，则返回异常代码。
+	char *HostAddress(int virtAddr, bool writing);
+	// 在主机页缓存中查找"virtAddr"，命中时设置使用和脏位并
+	// 返回其主机地址；未命中返回NULL，调用者应改用Translate。
+	// 调用者负责检查对齐。
 
 	void RaiseException(ExceptionType which, int badVAddr);
 	// 因系统调用或其他异常而陷入Nachos内核。
 
+	void UseTLB(int numEntries, int ways, TLBPolicy policy);
+	// 启用一个"numEntries"项、每组"ways"项的TLB
+
 	void Debugger();  // 调用用户程序调试器
 	void DumpState(); // 打印用户CPU和内存状态
+	void WriteState(char *fileName);
+	// 把寄存器、用户时钟和整个主存写到文件，便于比较两次运行
 
 	// 数据结构 -- 所有这些都可以被Nachos内核代码访问。
 	// “public”是为了方便。
@@ -145,33 +215,44 @@ public:
 	char *mainMemory; // 存储用户程序的物理内存，
 					  // 在执行时存储代码和数据
 	int registers[NumTotalRegs]; // 执行用户程序的CPU寄存器
+	char *stateFile; // 非NULL时，停机（释放Machine）时调用WriteState
 
 	// 注意：用户程序中虚拟地址到物理地址的硬件翻译
 	// （相对于“mainMemory”的起始位置）
 	// 可以通过以下方式控制：
 	//	传统的线性页表
-	//  	软件加载的翻译后备缓冲区（tlb） -- 一个缓存
-	//	  虚拟页号到物理页号的映射
+	//  	翻译后备缓冲区（tlb） -- 页表项的组相联缓存，
+	//	  未命中时由硬件查找页表并装入（见 translate.h）
 	//
-	// 如果“tlb”为NULL，则使用线性页表
-	// 如果“tlb”非NULL，则Nachos内核负责管理
-	//	TLB的内容。
-	// 但内核可以使用任何数据结构
-	//	它想要（例如，分段分页）来处理TLB缓存未命中。
+	// 如果“tlb”为NULL，每次引用都查找线性页表。
+	// 如果“tlb”非NULL，先查找TLB。TLB中的项带有地址空间
+	// 标识（asid），因此内核在切换地址空间时只需设置
+	// “pageTable”和“asid”，而在销毁地址空间时调用
+	// tlb->FlushASID 清除它的项。
 	//
 	// 为了简单起见，页表指针和TLB指针都是
 	// 公共的。然而，虽然可以有多个页表（每个地址
 	// 空间一个，存储在内存中），但只有一个TLB（在硬件中实现）。
-	// 因此，TLB指针应被视为*只读*，尽管
-	// TLB的内容可以被内核软件修改。
+	// 因此，TLB指针应被视为*只读*。
 
-	TranslationEntry *tlb; // 此指针应被视为
-						   // 对Nachos内核代码“只读”
+	TLB *tlb; // 此指针应被视为
+			  // 对Nachos内核代码“只读”
+	int asid; // 当前地址空间的标识，用作TLB项的标记
 
 	TranslationEntry *pageTable;
 	unsigned int pageTableSize;
 
 private:
+	Instruction *decodeCache; // 按物理地址索引的预解码指令缓存，
+							  // 每个物理页 PageSize/4 项。条目中保存
+							  // 解码时的原始字，取指时与内存比较，
+							  // 内存被改写（写入、换入、重新映射）后自动失效
+	TranslatedBlock **blockCache; // 按起始物理地址索引的已翻译块，
+								  // 仅在基本块翻译模式下分配
+	bool blockMode;	 // 以基本块翻译模式执行用户程序
+	int pendingTicks; // 当前批（块）中此前已执行、尚未计入时钟的指令数
+	HostPageEntry hostPages[HostPageCacheSize]; // 主机页缓存，由Translate填入
+	bool traceMem;	  // 打开了'a'调试标志，每次访问都走Translate以打印信息
 	bool singleStep; // 在每条
 					 // 模拟指令后返回到调试器
 	int runUntilTime; // 当模拟
@@ -24,16 +24,33 @@ static void Mult(int a, int b, bool signedArith, int *hiPtr, int *loPtr);
 
 void Machine::Run()
 {
-	Instruction *instr = new Instruction; // 存储解码指令的空间
+	int batch, executed;
 
 	if (DebugIsEnabled('m'))
 		printf("正在启动线程 \"%s\"，时间 %d\n",
 			   currentThread->getName(), stats->totalTicks);
 	interrupt->setStatus(UserMode);
+	if (blockMode && !singleStep && !DebugIsEnabled('m'))
+		RunBlocks(); // 永不返回
 	for (;;)
 	{
-		OneInstruction(instr);
-		interrupt->OneTick();
+		// 在下一个待处理中断到期之前连续执行一批指令，然后一次性
+		// 推进时钟。陷入内核时 RaiseException 先结算此前的指令，
+		// 返回后重新计算批量，因此时间与逐条推进完全一致。
+		batch = 1;
+		if (!singleStep)
+			batch = (interrupt->TicksUntilDue() - 1) / UserTick + 1;
+		for (executed = 0; executed < batch;)
+		{
+			pendingTicks = executed++;
+			if (!OneInstruction())
+			{
+				executed = 1;
+				break;
+			}
+		}
+		pendingTicks = 0;
+		interrupt->OneTick(executed);
 		if (singleStep && (runUntilTime <= stats->totalTicks))
 			Debugger();
 	}
@@ -62,6 +79,51 @@ TypeToReg(RegType reg, Instruction *instr)
 	}
 }
 
+//----------------------------------------------------------------------
+// Machine::FetchInstruction
+// 	取出当前PC处的指令。
+//
+//	解码结果按物理地址缓存在 decodeCache 中：每个条目记录
+//	解码时的原始指令字，只有当内存中的字与之不同时才重新解码。
+//	因此内核直接改写 mainMemory（加载程序、换入页面）或
+//	改变页表映射时，无需显式使缓存失效。
+//
+//	PC所在的页通常已在主机页缓存中，此时不必调用 Translate。
+//
+//	如果地址翻译失败，引发异常并返回NULL。
+//----------------------------------------------------------------------
+
+Instruction *
+Machine::FetchInstruction()
+{
+	int physAddr;
+	unsigned int raw;
+	Instruction *instr;
+	ExceptionType exception;
+	char *host;
+
+	if (traceMem || (registers[PCReg] & 0x3) != 0 ||
+		(host = HostAddress(registers[PCReg], FALSE)) == NULL)
+	{
+		exception = Translate(registers[PCReg], &physAddr, 4, FALSE);
+		if (exception != NoException)
+		{
+			RaiseException(exception, registers[PCReg]);
+			return NULL;
+		}
+	}
+	else
+		physAddr = host - mainMemory;
+	raw = WordToHost(*(unsigned int *)&mainMemory[physAddr]);
+	instr = &decodeCache[physAddr >> 2];
+	if (instr->value != raw)
+	{
+		instr->value = raw;
+		instr->Decode();
+	}
+	return instr;
+}
+
 //----------------------------------------------------------------------
 // Machine::OneInstruction
 // 	执行用户级程序中的一条指令
@@ -80,20 +142,34 @@ TypeToReg(RegType reg, Instruction *instr)
 //	仿真（或在异常或中断后返回到 Nachos 内核时），并且我们总是
 //	在离开之前将所有数据存储回机器寄存器和内存中。
 //	这允许 Nachos 内核通过控制内存、翻译表和寄存器集的内容来控制我们的行为。
+//
+//	如果陷入了内核（异常或系统调用），返回 FALSE。
 //----------------------------------------------------------------------
 
-void Machine::OneInstruction(Instruction *instr)
+bool Machine::OneInstruction()
+{
+	Instruction *instr;
+
+	// 获取指令（从预解码缓存）
+	if ((instr = FetchInstruction()) == NULL)
+		return FALSE; // 发生异常
+	return ExecuteInstruction(instr);
+}
+
+//----------------------------------------------------------------------
+// Machine::ExecuteInstruction
+// 	执行一条已解码的指令，包括延迟加载和 PC 的推进。
+//	这是指令语义的参考实现，基本块翻译模式中
+//	没有专门处理函数的指令也由它执行。
+//
+//	如果发生异常或系统调用（已陷入内核并返回），返回 FALSE。
+//----------------------------------------------------------------------
+
+bool Machine::ExecuteInstruction(Instruction *instr)
 {
-	int raw;
 	int nextLoadReg = 0;
 	int nextLoadValue = 0; // 记录延迟加载操作，以便将来应用
 
-	// 获取指令
-	if (!machine->ReadMem(registers[PCReg], 4, &raw))
-		return; // 发生异常
-	instr->value = raw;
-	instr->Decode();
-
 	if (DebugIsEnabled('m'))
 	{
 		struct OpString *str = &opStrings[instr->opCode];
@@ -120,7 +196,7 @@ void Machine::OneInstruction(Instruction *instr)
 			((registers[instr->rs] ^ sum) & SIGN_BIT))
 		{
 			RaiseException(OverflowException, 0);
-			return;
+			return FALSE;
 		}
 		registers[instr->rd] = sum;
 		break;
@@ -131,7 +207,7 @@ void Machine::OneInstruction(Instruction *instr)
 			((instr->extra ^ sum) & SIGN_BIT))
 		{
 			RaiseException(OverflowException, 0);
-			return;
+			return FALSE;
 		}
 		registers[instr->rt] = sum;
 		break;
@@ -232,7 +308,7 @@ void Machine::OneInstruction(Instruction *instr)
 	case OP_LBU:
 		tmp = registers[instr->rs] + instr->extra;
 		if (!machine->ReadMem(tmp, 1, &value))
-			return;
+			return FALSE;
 
 		if ((value & 0x80) && (instr->opCode == OP_LB))
 			value |= 0xffffff00;
@@ -248,10 +324,10 @@ void Machine::OneInstruction(Instruction *instr)
 		if (tmp & 0x1)
 		{
 			RaiseException(AddressErrorException, tmp);
-			return;
+			return FALSE;
 		}
 		if (!machine->ReadMem(tmp, 2, &value))
-			return;
+			return FALSE;
 
 		if ((value & 0x8000) && (instr->opCode == OP_LH))
 			value |= 0xffff0000;
@@ -271,10 +347,10 @@ void Machine::OneInstruction(Instruction *instr)
 		if (tmp & 0x3)
 		{
 			RaiseException(AddressErrorException, tmp);
-			return;
+			return FALSE;
 		}
 		if (!machine->ReadMem(tmp, 4, &value))
-			return;
+			return FALSE;
 		nextLoadReg = instr->rt;
 		nextLoadValue = value;
 		break;
@@ -288,7 +364,7 @@ void Machine::OneInstruction(Instruction *instr)
 		ASSERT((tmp & 0x3) == 0);
 
 		if (!machine->ReadMem(tmp, 4, &value))
-			return;
+			return FALSE;
 		if (registers[LoadReg] == instr->rt)
 			nextLoadValue = registers[LoadValueReg];
 		else
@@ -320,7 +396,7 @@ void Machine::OneInstruction(Instruction *instr)
 		ASSERT((tmp & 0x3) == 0);
 
 		if (!machine->ReadMem(tmp, 4, &value))
-			return;
+			return FALSE;
 		if (registers[LoadReg] == instr->rt)
 			nextLoadValue = registers[LoadValueReg];
 		else
@@ -385,12 +461,12 @@ void Machine::OneInstruction(Instruction *instr)
 
 	case OP_SB:
 		if (!machine->WriteMem((unsigned)(registers[instr->rs] + instr->extra), 1, registers[instr->rt]))
-			return;
+			return FALSE;
 		break;
 
 	case OP_SH:
 		if (!machine->WriteMem((unsigned)(registers[instr->rs] + instr->extra), 2, registers[instr->rt]))
-			return;
+			return FALSE;
 		break;
 
 	case OP_SLL:
@@ -460,7 +536,7 @@ void Machine::OneInstruction(Instruction *instr)
 			((registers[instr->rs] ^ diff) & SIGN_BIT))
 		{
 			RaiseException(OverflowException, 0);
-			return;
+			return FALSE;
 		}
 		registers[instr->rd] = diff;
 		break;
@@ -471,7 +547,7 @@ void Machine::OneInstruction(Instruction *instr)
 
 	case OP_SW:
 		if (!machine->WriteMem((unsigned)(registers[instr->rs] + instr->extra), 4, registers[instr->rt]))
-			return;
+			return FALSE;
 		break;
 
 	case OP_SWL:
@@ -482,7 +558,7 @@ void Machine::OneInstruction(Instruction *instr)
 		ASSERT((tmp & 0x3) == 0);
 
 		if (!machine->ReadMem((tmp & ~0x3), 4, &value))
-			return;
+			return FALSE;
 		switch (tmp & 0x3)
 		{
 		case 0:
@@ -502,7 +578,7 @@ void Machine::OneInstruction(Instruction *instr)
 			break;
 		}
 		if (!machine->WriteMem((tmp & ~0x3), 4, value))
-			return;
+			return FALSE;
 		break;
 
 	case OP_SWR:
@@ -513,7 +589,7 @@ void Machine::OneInstruction(Instruction *instr)
 		ASSERT((tmp & 0x3) == 0);
 
 		if (!machine->ReadMem((tmp & ~0x3), 4, &value))
-			return;
+			return FALSE;
 		switch (tmp & 0x3)
 		{
 		case 0:
@@ -530,12 +606,12 @@ void Machine::OneInstruction(Instruction *instr)
 			break;
 		}
 		if (!machine->WriteMem((tmp & ~0x3), 4, value))
-			return;
+			return FALSE;
 		break;
 
 	case OP_SYSCALL:
 		RaiseException(SyscallException, 0);
-		return;
+		return FALSE;
 
 	case OP_XOR:
 		registers[instr->rd] = registers[instr->rs] ^ registers[instr->rt];
@@ -548,7 +624,7 @@ void Machine::OneInstruction(Instruction *instr)
 	case OP_RES:
 	case OP_UNIMP:
 		RaiseException(IllegalInstrException, 0);
-		return;
+		return FALSE;
 
 	default:
 		ASSERT(FALSE);
@@ -564,6 +640,7 @@ void Machine::OneInstruction(Instruction *instr)
 											 // 跳入无效地址
 	registers[PCReg] = registers[NextPCReg];
 	registers[NextPCReg] = pcAfter;
+	return TRUE;
 }
 
 //----------------------------------------------------------------------
@@ -715,3 +792,411 @@ Mult(int a, int b, bool signedArith, int *hiPtr, int *loPtr)
 	*hiPtr = (int)hi;
 	*loPtr = (int)lo;
 }
+
+//----------------------------------------------------------------------
+// 基本块翻译模式
+//
+//	常用指令有专门的处理函数，直接操作寄存器；其余指令
+//	交给 ExecuteInstruction 执行。每个处理函数必须与参考解释器
+//	的语义（包括延迟加载、PC 推进以及解释器中已有的怪癖）完全一致。
+//----------------------------------------------------------------------
+
+// 完成一条非分支指令：执行延迟加载并顺序推进 PC
+static inline void
+Retire(int *registers, int nextLoadReg, int nextLoadValue)
+{
+	registers[registers[LoadReg]] = registers[LoadValueReg];
+	registers[LoadReg] = nextLoadReg;
+	registers[LoadValueReg] = nextLoadValue;
+	registers[0] = 0;
+	registers[PrevPCReg] = registers[PCReg];
+	registers[PCReg] = registers[NextPCReg];
+	registers[NextPCReg] = registers[PCReg] + 4;
+}
+
+// 完成一条分支指令：执行延迟加载，PC 进入延迟槽，延迟槽之后到 "pcAfter"
+static inline void
+RetireBranch(int *registers, int pcAfter)
+{
+	registers[registers[LoadReg]] = registers[LoadValueReg];
+	registers[LoadReg] = 0;
+	registers[LoadValueReg] = 0;
+	registers[0] = 0;
+	registers[PrevPCReg] = registers[PCReg];
+	registers[PCReg] = registers[NextPCReg];
+	registers[NextPCReg] = pcAfter;
+}
+
+static bool
+ExecGeneric(Machine *m, Instruction *instr)
+{
+	return m->ExecuteInstruction(instr);
+}
+
+#define ALU_HANDLER(name, dest, expr)                   \
+	static bool                                         \
+	name(Machine *m, Instruction *instr)                \
+	{                                                   \
+		int *registers = m->registers;                  \
+		registers[instr->dest] = (expr);                \
+		Retire(registers, 0, 0);                        \
+		return TRUE;                                    \
+	}
+
+ALU_HANDLER(ExecADDIU, rt, registers[instr->rs] + instr->extra)
+ALU_HANDLER(ExecADDU, rd, registers[instr->rs] + registers[instr->rt])
+ALU_HANDLER(ExecSUBU, rd, registers[instr->rs] - registers[instr->rt])
+ALU_HANDLER(ExecAND, rd, registers[instr->rs] & registers[instr->rt])
+ALU_HANDLER(ExecANDI, rt, registers[instr->rs] & (instr->extra & 0xffff))
+ALU_HANDLER(ExecOR, rd, registers[instr->rs] | registers[instr->rs]) // 与解释器一致
+ALU_HANDLER(ExecORI, rt, registers[instr->rs] | (instr->extra & 0xffff))
+ALU_HANDLER(ExecXOR, rd, registers[instr->rs] ^ registers[instr->rt])
+ALU_HANDLER(ExecXORI, rt, registers[instr->rs] ^ (instr->extra & 0xffff))
+ALU_HANDLER(ExecNOR, rd, ~(registers[instr->rs] | registers[instr->rt]))
+ALU_HANDLER(ExecLUI, rt, instr->extra << 16)
+ALU_HANDLER(ExecSLL, rd, registers[instr->rt] << instr->extra)
+ALU_HANDLER(ExecSLLV, rd, registers[instr->rt] << (registers[instr->rs] & 0x1f))
+ALU_HANDLER(ExecSRA, rd, registers[instr->rt] >> instr->extra)
+ALU_HANDLER(ExecSRAV, rd, registers[instr->rt] >> (registers[instr->rs] & 0x1f))
+ALU_HANDLER(ExecSRL, rd, registers[instr->rt] >> instr->extra) // 与解释器一致：有符号移位
+ALU_HANDLER(ExecSRLV, rd, registers[instr->rt] >> (registers[instr->rs] & 0x1f))
+ALU_HANDLER(ExecSLT, rd, registers[instr->rs] < registers[instr->rt])
+ALU_HANDLER(ExecSLTI, rt, registers[instr->rs] < instr->extra)
+ALU_HANDLER(ExecSLTU, rd, (unsigned int)registers[instr->rs] < (unsigned int)registers[instr->rt])
+ALU_HANDLER(ExecSLTIU, rt, (unsigned int)registers[instr->rs] < (unsigned int)instr->extra)
+ALU_HANDLER(ExecMFHI, rd, registers[HiReg])
+ALU_HANDLER(ExecMFLO, rd, registers[LoReg])
+
+#define BRANCH_HANDLER(name, cond)                                              \
+	static bool                                                                 \
+	name(Machine *m, Instruction *instr)                                        \
+	{                                                                           \
+		int *registers = m->registers;                                          \
+		int pcAfter = registers[NextPCReg] + 4;                                 \
+		if (cond)                                                               \
+			pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);         \
+		RetireBranch(registers, pcAfter);                                       \
+		return TRUE;                                                            \
+	}
+
+BRANCH_HANDLER(ExecBEQ, registers[instr->rs] == registers[instr->rt])
+BRANCH_HANDLER(ExecBNE, registers[instr->rs] != registers[instr->rt])
+BRANCH_HANDLER(ExecBLEZ, registers[instr->rs] <= 0)
+BRANCH_HANDLER(ExecBGTZ, registers[instr->rs] > 0)
+BRANCH_HANDLER(ExecBLTZ, registers[instr->rs] & SIGN_BIT)
+BRANCH_HANDLER(ExecBGEZ, !(registers[instr->rs] & SIGN_BIT))
+
+static bool
+ExecJ(Machine *m, Instruction *instr)
+{
+	int *registers = m->registers;
+
+	RetireBranch(registers, ((registers[NextPCReg] + 4) & 0xf0000000) |
+								IndexToAddr(instr->extra));
+	return TRUE;
+}
+
+static bool
+ExecJAL(Machine *m, Instruction *instr)
+{
+	int *registers = m->registers;
+
+	registers[R31] = registers[NextPCReg] + 4;
+	return ExecJ(m, instr);
+}
+
+static bool
+ExecJR(Machine *m, Instruction *instr)
+{
+	int *registers = m->registers;
+
+	RetireBranch(registers, registers[instr->rs]);
+	return TRUE;
+}
+
+static bool
+ExecJALR(Machine *m, Instruction *instr)
+{
+	int *registers = m->registers;
+
+	registers[instr->rd] = registers[NextPCReg] + 4;
+	RetireBranch(registers, registers[instr->rs]);
+	return TRUE;
+}
+
+static bool
+ExecLW(Machine *m, Instruction *instr)
+{
+	int *registers = m->registers;
+	int addr = registers[instr->rs] + instr->extra;
+	int value;
+
+	if (addr & 0x3)
+	{
+		m->RaiseException(AddressErrorException, addr);
+		return FALSE;
+	}
+	if (!m->ReadMem(addr, 4, &value))
+		return FALSE;
+	Retire(registers, instr->rt, value);
+	return TRUE;
+}
+
+static bool
+ExecLBU(Machine *m, Instruction *instr)
+{
+	int *registers = m->registers;
+	int value;
+
+	if (!m->ReadMem(registers[instr->rs] + instr->extra, 1, &value))
+		return FALSE;
+	Retire(registers, instr->rt, value & 0xff);
+	return TRUE;
+}
+
+static bool
+ExecLB(Machine *m, Instruction *instr)
+{
+	int *registers = m->registers;
+	int value;
+
+	if (!m->ReadMem(registers[instr->rs] + instr->extra, 1, &value))
+		return FALSE;
+	if (value & 0x80)
+		value |= 0xffffff00;
+	else
+		value &= 0xff;
+	Retire(registers, instr->rt, value);
+	return TRUE;
+}
+
+#define STORE_HANDLER(name, size)                                               \
+	static bool                                                                 \
+	name(Machine *m, Instruction *instr)                                        \
+	{                                                                           \
+		int *registers = m->registers;                                          \
+		if (!m->WriteMem((unsigned)(registers[instr->rs] + instr->extra),      \
+						 size, registers[instr->rt]))                           \
+			return FALSE;                                                       \
+		Retire(registers, 0, 0);                                                \
+		return TRUE;                                                            \
+	}
+
+STORE_HANDLER(ExecSW, 4)
+STORE_HANDLER(ExecSH, 2)
+STORE_HANDLER(ExecSB, 1)
+
+// 按操作码索引的处理函数表，首次使用时建立
+static InstrHandler handlerTable[MaxOpcode + 1];
+
+static void
+InitHandlerTable()
+{
+	for (int i = 0; i <= MaxOpcode; i++)
+		handlerTable[i] = ExecGeneric;
+	handlerTable[OP_ADDIU] = ExecADDIU;
+	handlerTable[OP_ADDU] = ExecADDU;
+	handlerTable[OP_SUBU] = ExecSUBU;
+	handlerTable[OP_AND] = ExecAND;
+	handlerTable[OP_ANDI] = ExecANDI;
+	handlerTable[OP_OR] = ExecOR;
+	handlerTable[OP_ORI] = ExecORI;
+	handlerTable[OP_XOR] = ExecXOR;
+	handlerTable[OP_XORI] = ExecXORI;
+	handlerTable[OP_NOR] = ExecNOR;
+	handlerTable[OP_LUI] = ExecLUI;
+	handlerTable[OP_SLL] = ExecSLL;
+	handlerTable[OP_SLLV] = ExecSLLV;
+	handlerTable[OP_SRA] = ExecSRA;
+	handlerTable[OP_SRAV] = ExecSRAV;
+	handlerTable[OP_SRL] = ExecSRL;
+	handlerTable[OP_SRLV] = ExecSRLV;
+	handlerTable[OP_SLT] = ExecSLT;
+	handlerTable[OP_SLTI] = ExecSLTI;
+	handlerTable[OP_SLTU] = ExecSLTU;
+	handlerTable[OP_SLTIU] = ExecSLTIU;
+	handlerTable[OP_MFHI] = ExecMFHI;
+	handlerTable[OP_MFLO] = ExecMFLO;
+	handlerTable[OP_BEQ] = ExecBEQ;
+	handlerTable[OP_BNE] = ExecBNE;
+	handlerTable[OP_BLEZ] = ExecBLEZ;
+	handlerTable[OP_BGTZ] = ExecBGTZ;
+	handlerTable[OP_BLTZ] = ExecBLTZ;
+	handlerTable[OP_BGEZ] = ExecBGEZ;
+	handlerTable[OP_J] = ExecJ;
+	handlerTable[OP_JAL] = ExecJAL;
+	handlerTable[OP_JR] = ExecJR;
+	handlerTable[OP_JALR] = ExecJALR;
+	handlerTable[OP_LW] = ExecLW;
+	handlerTable[OP_LB] = ExecLB;
+	handlerTable[OP_LBU] = ExecLBU;
+	handlerTable[OP_SW] = ExecSW;
+	handlerTable[OP_SH] = ExecSH;
+	handlerTable[OP_SB] = ExecSB;
+}
+
+// 该指令之后是否有分支延迟槽（即块在延迟槽之后结束）
+static bool
+IsBranch(int opCode)
+{
+	switch (opCode)
+	{
+	case OP_BEQ:
+	case OP_BNE:
+	case OP_BLEZ:
+	case OP_BGTZ:
+	case OP_BLTZ:
+	case OP_BGEZ:
+	case OP_BLTZAL:
+	case OP_BGEZAL:
+	case OP_J:
+	case OP_JAL:
+	case OP_JR:
+	case OP_JALR:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+//----------------------------------------------------------------------
+// Machine::RunBlocks
+// 	以基本块翻译模式运行用户程序；永不返回。
+//
+//	每次从 PC 处取出一个已翻译的块，依次调用各指令的处理函数，
+//	然后一次性推进块中已执行指令数的时钟。处理函数返回 FALSE
+//	（异常或系统调用，内核已处理完毕）时提前结束该块；
+//	陷入内核之前 RaiseException 先结算此前指令的时钟，
+//	与解释器一样，引发异常的指令本身在返回后计一个时钟。
+//	块在下一个待处理中断到期处截断，因此中断在与解释器
+//	相同的指令边界上触发。
+//
+//	如果 PC 位于延迟槽中（NextPC != PC + 4，例如在延迟槽中
+//	发生页面错误后重新执行），则逐条解释该指令。
+//----------------------------------------------------------------------
+
+void Machine::RunBlocks()
+{
+	TranslatedBlock *block;
+	int executed, limit;
+
+	for (;;)
+	{
+		if (registers[NextPCReg] != registers[PCReg] + 4)
+		{
+			OneInstruction();
+			interrupt->OneTick();
+			continue;
+		}
+		if ((block = FindBlock()) == NULL)
+		{
+			interrupt->OneTick(); // 取指异常
+			continue;
+		}
+		limit = (interrupt->TicksUntilDue() - 1) / UserTick + 1;
+		if (limit > block->length)
+			limit = block->length;
+		for (executed = 0; executed < limit;)
+		{
+			BlockEntry *entry = &block->entries[executed];
+			pendingTicks = executed++;
+			if (!(*entry->handler)(this, &entry->instr))
+			{ // 陷入内核时 RaiseException 已结算此前的指令
+				executed = 1;
+				break;
+			}
+		}
+		pendingTicks = 0;
+		interrupt->OneTick(executed);
+	}
+}
+
+//----------------------------------------------------------------------
+// Machine::FindBlock
+// 	翻译 PC，返回从该物理地址开始的块。
+//
+//	与预解码缓存一样，块中保存了每条指令的原始字；
+//	使用前与内存比较，内容不同（页面被换出/换入、
+//	程序被重新加载）时重新翻译该块。块内的指令改写
+//	本块自身（自修改代码）不会被检测到。
+//----------------------------------------------------------------------
+
+TranslatedBlock *
+Machine::FindBlock()
+{
+	int physAddr, i;
+	unsigned int *words;
+	TranslatedBlock *block;
+	ExceptionType exception;
+	char *host;
+
+	if (traceMem || (registers[PCReg] & 0x3) != 0 ||
+		(host = HostAddress(registers[PCReg], FALSE)) == NULL)
+	{
+		exception = Translate(registers[PCReg], &physAddr, 4, FALSE);
+		if (exception != NoException)
+		{
+			RaiseException(exception, registers[PCReg]);
+			return NULL;
+		}
+	}
+	else
+		physAddr = host - mainMemory;
+	words = (unsigned int *)&mainMemory[physAddr];
+	block = blockCache[physAddr >> 2];
+	if (block == NULL)
+	{
+		block = new TranslatedBlock;
+		blockCache[physAddr >> 2] = block;
+	}
+	else
+	{
+		for (i = 0; i < block->length; i++)
+			if (block->entries[i].instr.value != WordToHost(words[i]))
+				break;
+		if (i == block->length)
+			return block;
+	}
+	TranslateBlock(block, physAddr);
+	return block;
+}
+
+//----------------------------------------------------------------------
+// Machine::TranslateBlock
+// 	从物理地址 "physAddr" 开始解码指令，直到系统调用、
+//	分支及其延迟槽，或者到达物理页的末尾。
+//----------------------------------------------------------------------
+
+void Machine::TranslateBlock(TranslatedBlock *block, int physAddr)
+{
+	unsigned int *words = (unsigned int *)&mainMemory[physAddr];
+	int limit = (PageSize - (physAddr % PageSize)) / 4; // 不跨越物理页
+	int n = 0;
+	BlockEntry *entry;
+
+	if (handlerTable[0] == NULL)
+		InitHandlerTable();
+	while (n < limit)
+	{
+		entry = &block->entries[n];
+		entry->instr.value = WordToHost(words[n]);
+		entry->instr.Decode();
+		entry->handler = handlerTable[entry->instr.opCode];
+		n++;
+		if (entry->instr.opCode == OP_SYSCALL)
+			break;
+		if (IsBranch(entry->instr.opCode))
+		{
+			if (n < limit)
+			{ // 把延迟槽并入本块
+				entry = &block->entries[n];
+				entry->instr.value = WordToHost(words[n]);
+				entry->instr.Decode();
+				entry->handler = handlerTable[entry->instr.opCode];
+				n++;
+			}
+			break;
+		}
+	}
+	block->length = n;
+}
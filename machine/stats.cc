@@ -18,8 +18,13 @@ Statistics::Statistics()
 {
     totalTicks = idleTicks = systemTicks = userTicks = 0;
     numDiskReads = numDiskWrites = 0;
+    numDiskSectorsRead = numDiskSectorsWritten = 0;
+    numDiskTracksMoved = numDiskRequests = diskRequestTicks = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numCacheHits = numCacheMisses = numCacheWriteBacks = 0;
+    for (int i = 0; i <= MaxStatSpaces; i++)
+	tlbHits[i] = tlbMisses[i] = tlbEvictions[i] = 0;
 }
 
 //----------------------------------------------------------------------
@@ -33,9 +38,48 @@ Statistics::Print()
     printf("时钟周期: 总计 %d, 空闲 %d, 系统 %d, 用户 %d\n", totalTicks, 
 	idleTicks, systemTicks, userTicks);
     printf("磁盘I/O: 读取 %d, 写入 %d\n", numDiskReads, numDiskWrites);
+    if (numDiskSectorsRead + numDiskSectorsWritten
+	    != numDiskReads + numDiskWrites)	// 有多扇区请求
+	printf("磁盘扇区: 读取 %d, 写入 %d\n", numDiskSectorsRead,
+	    numDiskSectorsWritten);
+    if (numDiskRequests > 0)
+	printf("磁盘调度: 磁头移动 %d 道, 平均请求延迟 %d\n",
+	    numDiskTracksMoved, diskRequestTicks / numDiskRequests);
     printf("控制台I/O: 读取 %d, 写入 %d\n", numConsoleCharsRead, 
 	numConsoleCharsWritten);
     printf("分页: 页面错误 %d\n", numPageFaults);
     printf("网络I/O: 接收的数据包 %d, 发送的数据包 %d\n", numPacketsRecvd, 
 	numPacketsSent);
+    if (numCacheHits + numCacheMisses > 0)	// 使用了扇区缓存
+	printf("磁盘缓存: 命中 %d, 未命中 %d, 写回 %d\n", numCacheHits,
+	    numCacheMisses, numCacheWriteBacks);
+    PrintTLB();
+}
+
+//----------------------------------------------------------------------
+// Statistics::PrintTLB
+// 	打印 TLB 的统计信息（总计，以及每个地址空间）。
+//	没有使用 TLB 时不打印。
+//----------------------------------------------------------------------
+
+void
+Statistics::PrintTLB()
+{
+    int i, hits = 0, misses = 0, evictions = 0;
+
+    for (i = 0; i <= MaxStatSpaces; i++) {
+	hits += tlbHits[i];
+	misses += tlbMisses[i];
+	evictions += tlbEvictions[i];
+    }
+    if (hits + misses == 0)
+	return;
+    printf("TLB: 命中 %d, 未命中 %d, 替换 %d\n", hits, misses, evictions);
+    for (i = 0; i < MaxStatSpaces; i++)
+	if (tlbHits[i] + tlbMisses[i] + tlbEvictions[i] > 0)
+	    printf("  地址空间 %d: 命中 %d, 未命中 %d, 替换 %d\n", i,
+		tlbHits[i], tlbMisses[i], tlbEvictions[i]);
+    if (tlbHits[i] + tlbMisses[i] + tlbEvictions[i] > 0)
+	printf("  其他地址空间: 命中 %d, 未命中 %d, 替换 %d\n",
+	    tlbHits[i], tlbMisses[i], tlbEvictions[i]);
 }
@@ -13,6 +13,11 @@
 //
 // 该类中的字段是公共的，以便于更新。
 
+#define MaxStatSpaces 16	// 分别统计 TLB 的地址空间数
+				// 其余地址空间合计在下标 MaxStatSpaces 中
+#define StatSpace(asid) (((asid) >= 0 && (asid) < MaxStatSpaces) \
+			     ? (asid) : MaxStatSpaces)
+
 class Statistics {
   public:
     int totalTicks;      	// 运行Nachos的总时间
@@ -23,15 +28,29 @@ class Statistics {
 
     int numDiskReads;		// 磁盘读取请求的数量
     int numDiskWrites;		// 磁盘写入请求的数量
+    int numDiskSectorsRead;	// 读取的磁盘扇区数（一个请求可含多个扇区）
+    int numDiskSectorsWritten;	// 写入的磁盘扇区数
+    int numDiskTracksMoved;	// 磁头移动经过的轨道数
+    int numDiskRequests;	// SynchDisk 完成的请求数（合并前）
+    int diskRequestTicks;	// 这些请求从提交到完成的总时间
     int numConsoleCharsRead;	// 从键盘读取的字符数量
     int numConsoleCharsWritten; // 写入显示的字符数量
     int numPageFaults;		// 虚拟内存页面错误的数量
     int numPacketsSent;		// 发送的网络数据包数量
     int numPacketsRecvd;	// 接收的网络数据包数量
+    int numCacheHits;		// 扇区缓存命中的次数
+    int numCacheMisses;		// 扇区缓存未命中的次数
+    int numCacheWriteBacks;	// 脏扇区写回磁盘的次数
+
+    int tlbHits[MaxStatSpaces + 1];	 // 每个地址空间的 TLB 命中次数，
+    int tlbMisses[MaxStatSpaces + 1];	 // 未命中次数，
+    int tlbEvictions[MaxStatSpaces + 1]; // 其 TLB 项被替换的次数
+					 // （按 StatSpace(asid) 记录）
 
     Statistics(); 		// 初始化所有值为零
 
     void Print();		// 打印收集的统计信息
+    void PrintTLB();		// 打印 TLB 的统计信息
 };
 
 // 用于反映操作在真实系统中所需的相对时间的常量。
@@ -31,7 +31,9 @@ extern "C"
 #include <sys/file.h>
 #include <sys/un.h>
 #include <sys/mman.h>
+#include <sys/uio.h>
 #include <sys/errno.h>
+#include <limits.h>
 #ifdef HOST_i386
 #include <sys/time.h>
 #endif
@@ -216,6 +218,101 @@ void Lseek(int fd, int offset, int whence)
     ASSERT(retVal >= 0);
 }
 
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+//----------------------------------------------------------------------
+// ReadVector
+// 	从打开的文件的 "offset" 处读取，依次填满 "nBuffers" 个缓冲区。
+//	每次 preadv 最多 IOV_MAX 个缓冲区，超过时分几次读。
+//	不改变文件的当前位置。如果出错则中止。
+//----------------------------------------------------------------------
+
+void ReadVector(int fd, char **buffers, int nBuffers, int bufferSize, int offset)
+{
+    int maxChunk = (nBuffers < IOV_MAX) ? nBuffers : IOV_MAX;
+    struct iovec *iov = new struct iovec[maxChunk];
+
+    for (int done = 0; done < nBuffers; done += maxChunk)
+    {
+        int chunk = (nBuffers - done < maxChunk) ? nBuffers - done : maxChunk;
+
+        for (int i = 0; i < chunk; i++)
+        {
+            iov[i].iov_base = buffers[done + i];
+            iov[i].iov_len = bufferSize;
+        }
+        int retVal = preadv(fd, iov, chunk, offset + done * bufferSize);
+        ASSERT(retVal == chunk * bufferSize);
+    }
+    delete[] iov;
+}
+
+//----------------------------------------------------------------------
+// WriteVector
+// 	把 "nBuffers" 个缓冲区依次写到打开的文件的 "offset" 处。
+//	每次 pwritev 最多 IOV_MAX 个缓冲区，超过时分几次写。
+//	不改变文件的当前位置。如果出错则中止。
+//----------------------------------------------------------------------
+
+void WriteVector(int fd, char **buffers, int nBuffers, int bufferSize, int offset)
+{
+    int maxChunk = (nBuffers < IOV_MAX) ? nBuffers : IOV_MAX;
+    struct iovec *iov = new struct iovec[maxChunk];
+
+    for (int done = 0; done < nBuffers; done += maxChunk)
+    {
+        int chunk = (nBuffers - done < maxChunk) ? nBuffers - done : maxChunk;
+
+        for (int i = 0; i < chunk; i++)
+        {
+            iov[i].iov_base = buffers[done + i];
+            iov[i].iov_len = bufferSize;
+        }
+        int retVal = pwritev(fd, iov, chunk, offset + done * bufferSize);
+        ASSERT(retVal == chunk * bufferSize);
+    }
+    delete[] iov;
+}
+
+//----------------------------------------------------------------------
+// MapFile
+// 	把打开的文件的前 "nBytes" 字节映射到内存。映射是共享的，
+//	对它的修改就是对文件的修改。如果出错则中止。
+//----------------------------------------------------------------------
+
+char *MapFile(int fd, int nBytes)
+{
+    void *addr = mmap(NULL, nBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    ASSERT(addr != MAP_FAILED);
+    return (char *)addr;
+}
+
+//----------------------------------------------------------------------
+// SyncMappedFile
+// 	把映射中修改过的页面写回文件。"wait" 为假时只安排写回，
+//	不等待它完成。
+//----------------------------------------------------------------------
+
+void SyncMappedFile(char *addr, int nBytes, bool wait)
+{
+    int retVal = msync(addr, nBytes, wait ? MS_SYNC : MS_ASYNC);
+    ASSERT(retVal == 0);
+}
+
+//----------------------------------------------------------------------
+// UnmapFile
+// 	解除 MapFile 建立的映射。
+//----------------------------------------------------------------------
+
+void UnmapFile(char *addr, int nBytes)
+{
+    int retVal = munmap(addr, nBytes);
+    ASSERT(retVal == 0);
+}
+
 //----------------------------------------------------------------------
 // Tell
 // 	报告打开文件中的当前位置。
@@ -18,6 +18,17 @@ extern void Read(int fd, char *buffer, int nBytes);
 extern int ReadPartial(int fd, char *buffer, int nBytes);
 extern void WriteFile(int fd, char *buffer, int nBytes);
 extern void Lseek(int fd, int offset, int whence);
+// 从文件的 "offset" 处开始，一次读取/写入 "nBuffers" 个
+// 各 "bufferSize" 字节的缓冲区（分散/聚集 I/O）。
+extern void ReadVector(int fd, char **buffers, int nBuffers, int bufferSize,
+                       int offset);
+extern void WriteVector(int fd, char **buffers, int nBuffers, int bufferSize,
+                        int offset);
+// 把打开的文件的前 "nBytes" 字节以共享方式映射到内存，
+// 把映射中的修改写回文件（"wait" 为真时等到写完），解除映射。
+extern char *MapFile(int fd, int nBytes);
+extern void SyncMappedFile(char *addr, int nBytes, bool wait);
+extern void UnmapFile(char *addr, int nBytes);
 extern int Tell(int fd);
 extern void Close(int fd);
 // extern bool Unlink(char *name);
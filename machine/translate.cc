@@ -8,19 +8,14 @@
 //	线性页表 -- 虚拟页号用作索引
 //	到表中，以找到物理页号。
 //
-//	翻译后备缓冲区 -- 在表中进行关联查找
-//	以找到具有相同虚拟页号的条目。如果找到，
-//	则使用该条目进行转换。
-//	如果没有，则会通过异常陷入软件。
+//	翻译后备缓冲区 -- 页表的组相联缓存（见 translate.h 中的
+//	TLB 类），以 <地址空间标识, 虚拟页号> 为标记。命中时直接使用
+//	缓存的页表项；未命中时由硬件查找页表，并把该项装入 TLB。
 //
-//	实际上，TLB的大小远小于物理内存的大小
-//	（在拥有数千页的机器上，16个条目是常见的）。因此，
-//	还必须有一个备份转换方案
-//	（例如页表），但硬件不需要知道
-//	任何关于此的事情。
-//
-//	请注意，TLB的内容是特定于地址空间的。
-//	如果地址空间发生变化，TLB的内容也会变化！
+//	TLB 的大小、相联度和替换策略在启动时设置（-tlb）。
+//	由于条目带有地址空间标识（ASID），切换地址空间时不必
+//	清空 TLB；内核只需在切换时设置 Machine::asid，
+//	并在销毁地址空间时清除它的条目。
 //
 // 不要更改 -- 机器仿真的一部分
 //
@@ -83,34 +78,41 @@ Machine::ReadMem(int addr, int size, int *value)
     int data;
     ExceptionType exception;
     int physicalAddress;
+    char *host;
     
-    DEBUG('a', "读取虚拟地址 0x%x, 大小 %d\n", addr, size);
+    // 快速路径：对齐访问且虚拟页在主机页缓存中
+    if (traceMem || (addr & (size - 1)) != 0
+	    || (host = HostAddress(addr, FALSE)) == NULL) {
+	DEBUG('a', "读取虚拟地址 0x%x, 大小 %d\n", addr, size);
     
-    exception = Translate(addr, &physicalAddress, size, FALSE);
-    if (exception != NoException) {
-	machine->RaiseException(exception, addr);
-	return FALSE;
+	exception = Translate(addr, &physicalAddress, size, FALSE);
+	if (exception != NoException) {
+	    machine->RaiseException(exception, addr);
+	    return FALSE;
+	}
+	host = &mainMemory[physicalAddress];
     }
     switch (size) {
       case 1:
-	data = machine->mainMemory[physicalAddress];
+	data = *host;
 	*value = data;
 	break;
 	
       case 2:
-	data = *(unsigned short *) &machine->mainMemory[physicalAddress];
+	data = *(unsigned short *) host;
 	*value = ShortToHost(data);
 	break;
 	
       case 4:
-	data = *(unsigned int *) &machine->mainMemory[physicalAddress];
+	data = *(unsigned int *) host;
 	*value = WordToHost(data);
 	break;
 
       default: ASSERT(FALSE);
     }
     
-    DEBUG('a', "\t读取的值 = %8.8x\n", *value);
+    if (traceMem)
+	DEBUG('a', "\t读取的值 = %8.8x\n", *value);
     return (TRUE);
 }
 
@@ -131,26 +133,32 @@ Machine::WriteMem(int addr, int size, int value)
 {
     ExceptionType exception;
     int physicalAddress;
+    char *host;
      
-    DEBUG('a', "写入虚拟地址 0x%x, 大小 %d, 值 0x%x\n", addr, size, value);
+    // 快速路径：对齐访问且虚拟页在主机页缓存中
+    if (traceMem || (addr & (size - 1)) != 0
+	    || (host = HostAddress(addr, TRUE)) == NULL) {
+	DEBUG('a', "写入虚拟地址 0x%x, 大小 %d, 值 0x%x\n", addr, size, value);
 
-    exception = Translate(addr, &physicalAddress, size, TRUE);
-    if (exception != NoException) {
-	machine->RaiseException(exception, addr);
-	return FALSE;
+	exception = Translate(addr, &physicalAddress, size, TRUE);
+	if (exception != NoException) {
+	    machine->RaiseException(exception, addr);
+	    return FALSE;
+	}
+	host = &mainMemory[physicalAddress];
     }
     switch (size) {
       case 1:
-	machine->mainMemory[physicalAddress] = (unsigned char) (value & 0xff);
+	*host = (unsigned char) (value & 0xff);
 	break;
 
       case 2:
-	*(unsigned short *) &machine->mainMemory[physicalAddress]
+	*(unsigned short *) host
 		= ShortToMachine((unsigned short) (value & 0xffff));
 	break;
       
       case 4:
-	*(unsigned int *) &machine->mainMemory[physicalAddress]
+	*(unsigned int *) host
 		= WordToMachine((unsigned int) value);
 	break;
 	
@@ -160,6 +168,40 @@ Machine::WriteMem(int addr, int size, int value)
     return TRUE;
 }
 
+//----------------------------------------------------------------------
+// Machine::HostAddress
+// 	在主机页缓存中查找 "virtAddr"（见 machine.h）。缓存项只有在
+//	页表、页表项、物理页和 TLB 项都与填入时相同，且写访问的页
+//	不是只读时才使用；此时像 Translate 一样设置使用和脏位，
+//	并返回主机地址。否则返回 NULL，由调用者走完整的 Translate
+//	（它会重新填入缓存项）。
+//
+//	调用者负责检查对齐。
+//
+//	"virtAddr" -- 要访问的虚拟地址
+// 	"writing" -- 如果为 TRUE，要求页可写，并设置脏位
+//----------------------------------------------------------------------
+
+char *
+Machine::HostAddress(int virtAddr, bool writing)
+{
+    unsigned int vpn = (unsigned) virtAddr / PageSize;
+    HostPageEntry *cached = &hostPages[vpn % HostPageCacheSize];
+    TranslationEntry *entry = cached->entry;
+
+    if (cached->virtualPage != (int) vpn || cached->table != pageTable
+	    || vpn >= pageTableSize || !entry->valid
+	    || entry->physicalPage != cached->frame
+	    || (writing && entry->readOnly))
+	return NULL;
+    if (tlb != NULL && !tlb->Touch(cached->slot, vpn, asid, entry))
+	return NULL;		// TLB 项已被替换：按 TLB 未命中处理
+    entry->use = TRUE;
+    if (writing)
+	entry->dirty = TRUE;
+    return cached->host + (unsigned) virtAddr % PageSize;
+}
+
 //----------------------------------------------------------------------
 // Machine::Translate
 // 	将虚拟地址转换为物理地址，使用 
@@ -176,10 +218,10 @@ Machine::WriteMem(int addr, int size, int value)
 ExceptionType
 Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 {
-    int i;
     unsigned int vpn, offset;
     TranslationEntry *entry;
     unsigned int pageFrame;
+    HostPageEntry *cached;
 
     DEBUG('a', "\t转换 0x%x, %s: ", virtAddr, writing ? "写入" : "读取");
 
@@ -189,15 +231,15 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 	return AddressErrorException;
     }
     
-    // 我们必须有 TLB 或页表，但不能同时有两者！
-    ASSERT(tlb == NULL || pageTable == NULL);	
-    ASSERT(tlb != NULL || pageTable != NULL);	
+    // 页表总是需要的；TLB 只是页表的缓存，未命中时由硬件查找页表
+    ASSERT(pageTable != NULL);	
 
 // 从虚拟地址计算虚拟页号和页内偏移
     vpn = (unsigned) virtAddr / PageSize;
     offset = (unsigned) virtAddr % PageSize;
     
-    if (tlb == NULL) {		// => 页表 => vpn 是表中的索引
+    if (tlb == NULL || (entry = tlb->Lookup(vpn, asid)) == NULL) {
+				// 无 TLB 或 TLB 未命中 => 查页表 => vpn 是表中的索引
 	if (vpn >= pageTableSize) {
 	    DEBUG('a', "虚拟页号 %d 超过页表大小 %d!\n", 
 			virtAddr, pageTableSize);
@@ -208,22 +250,12 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 	    return PageFaultException;
 	}
 	entry = &pageTable[vpn];
-    } else {
-        for (entry = NULL, i = 0; i < TLBSize; i++)
-    	    if (tlb[i].valid && ((unsigned int)tlb[i].virtualPage == vpn)) {
-		entry = &tlb[i];			// 找到！
-		break;
-	    }
-	if (entry == NULL) {				// 未找到
-    	    DEBUG('a', "*** 未找到此虚拟页的有效 TLB 条目!\n");
-    	    return PageFaultException;		// 实际上，这是一个 TLB 故障，
-						// 页可能在内存中，
-						// 但不在 TLB 中
-	}
+	if (tlb != NULL)
+	    tlb->Insert(vpn, asid, entry);	// 装入 TLB，可能替换一项
     }
 
     if (entry->readOnly && writing) {	// 尝试写入只读页
-	DEBUG('a', "%d 在 TLB 中映射为只读的 %d!\n", virtAddr, i);
+	DEBUG('a', "%d 映射为只读!\n", virtAddr);
 	return ReadOnlyException;
     }
     pageFrame = entry->physicalPage;
@@ -239,6 +271,14 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 	entry->dirty = TRUE;
     *physAddr = pageFrame * PageSize + offset;
     ASSERT((*physAddr >= 0) && ((*physAddr + size) <= MemorySize));
+
+    cached = &hostPages[vpn % HostPageCacheSize];	// 记入主机页缓存
+    cached->virtualPage = vpn;
+    cached->table = pageTable;
+    cached->entry = entry;
+    cached->frame = pageFrame;
+    cached->slot = (tlb != NULL) ? tlb->LastSlot() : NULL;
+    cached->host = &mainMemory[pageFrame * PageSize];
     DEBUG('a', "物理地址 = 0x%x\n", *physAddr);
     return NoException;
 }
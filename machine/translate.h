@@ -36,4 +36,58 @@ class TranslationEntry {
     bool dirty;         // 每次硬件修改该页时设置此位。
 };
 
+// TLB 的替换策略
+enum TLBPolicy { TLBLRU, TLBFIFO, TLBRandom };
+
+// TLB 中的一项：标记 <asid, 虚拟页号> 以及缓存的页表项
+
+class TLBSlot {
+  public:
+    bool valid;			// 该项是否在使用
+    int virtualPage;		// 标记：虚拟页号
+    int asid;			// 标记：地址空间标识
+    TranslationEntry *entry;	// 缓存的页表项
+    unsigned int stamp;		// 装入（FIFO）或最近使用（LRU）的时间
+};
+
+// 以下类定义了一个组相联的 TLB 模型。
+//
+// TLB 缓存当前页表中的项，未命中时由硬件查找页表并装入，
+// 内核只需维护页表。<虚拟页号, asid> 经散列选出一组，
+// 在组内相联查找；组满时按替换策略选出被替换的项。
+// 页表项失效（页被换出）时，对应的 TLB 项在下次查找时丢弃。
+//
+// 每个地址空间的命中、未命中和被替换次数记录在 Statistics 中。
+
+class TLB {
+  public:
+    TLB(int numEntries, int ways, TLBPolicy policy);
+				// 初始化一个有 "numEntries" 项、
+				// 每组 "ways" 项的 TLB
+    ~TLB();
+
+    TranslationEntry *Lookup(int vpn, int asid);
+				// 查找，未命中返回 NULL
+    void Insert(int vpn, int asid, TranslationEntry *entry);
+				// 装入一项，必要时替换组中的一项
+    void FlushASID(int asid);	// 清除一个地址空间的所有项
+    void FlushAll();		// 清空 TLB
+
+    TLBSlot *LastSlot() { return lastSlot; }
+				// 最近一次命中或装入的项
+    bool Touch(TLBSlot *slot, int vpn, int asid, TranslationEntry *entry);
+				// 若 "slot" 仍把 <vpn, asid> 映射到
+				// "entry"，按命中记账并返回 TRUE
+
+  private:
+    TLBSlot *slots;		// numSets 组，每组 ways 项
+    int numSets;
+    int ways;
+    TLBPolicy policy;
+    unsigned int clock;		// 用于 LRU/FIFO 的时间戳
+    TLBSlot *lastSlot;		// 最近一次命中或装入的项
+
+    TLBSlot *SetOf(int vpn, int asid);	// 返回 <vpn, asid> 所在组的第一项
+};
+
 #endif
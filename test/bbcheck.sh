@@ -0,0 +1,40 @@
+#!/bin/sh
+# bbcheck.sh
+#	基本块翻译模式（-bb）的差分测试：每个用户程序分别用解释器和
+#	-bb 运行，比较停机时写出的寄存器、用户时钟和主存（见 -dump）。
+#
+#	用法: bbcheck.sh <nachos> <程序.noff> ...
+#	例如在 lab7 目录下: sh ../test/bbcheck.sh ./nachos ../test/sort.noff
+#
+#	程序需要在 TIMEOUT 秒内调用 Halt；没有正常停机（例如断言失败）
+#	的程序记为跳过。有任何不同时返回 1。
+
+TIMEOUT=${TIMEOUT:-60}
+
+if [ $# -lt 2 ]; then
+    echo "用法: $0 <nachos> <程序.noff> ..."
+    exit 2
+fi
+nachos=$1
+shift
+
+tmp=${TMPDIR:-/tmp}/bbcheck.$$
+mkdir -p $tmp
+status=0
+for prog in "$@"; do
+    name=`basename $prog .noff`
+    rm -f $tmp/$name.interp $tmp/$name.bb
+    timeout $TIMEOUT $nachos -dump $tmp/$name.interp -x $prog > $tmp/$name.out1 2>&1 < /dev/null
+    timeout $TIMEOUT $nachos -bb -dump $tmp/$name.bb -x $prog > $tmp/$name.out2 2>&1 < /dev/null
+    if [ ! -f $tmp/$name.interp ] || [ ! -f $tmp/$name.bb ]; then
+	echo "$name: 跳过（没有正常停机）"
+    elif cmp -s $tmp/$name.interp $tmp/$name.bb; then
+	echo "$name: 相同"
+    else
+	echo "$name: 不同"
+	diff $tmp/$name.interp $tmp/$name.bb | head -20
+	status=1
+    fi
+done
+rm -rf $tmp
+exit $status
@@ -9,8 +9,9 @@
 // 	此文件的大部分内容在后续作业之前不需要。
 //
 // 用法: nachos -d <调试标志> -rs <随机种子 #>
-//		-s -x <nachos 文件> -c <控制台输入> <控制台输出>
-//		-f -cp <unix 文件> <nachos 文件>
+//		-s -bb -dump <文件> -tlb <条目数> <相联度> <策略> -x <nachos 文件> -c <控制台输入> <控制台输出>
+//		-f -bc <缓存扇区数> -ds <调度策略> -dm <写回策略>
+//		-dg <轨道数> <每轨扇区数> -cp <unix 文件> <nachos 文件>
 //		-p <nachos 文件> -r <nachos 文件> -l -D -t
 //              -n <网络可靠性> -e <网络可排序性>
 //              -m <机器 id>
@@ -23,11 +24,18 @@
 //
 //  用户程序
 //    -s 会导致用户程序以单步模式执行
+//    -bb 以基本块翻译模式执行用户程序（单步调试时无效）
+//    -dump 停机时把寄存器、用户时钟和主存写到文件，用于比较 -bb 与解释执行
+//    -tlb 使用带地址空间标识的组相联 TLB，策略为 lru、fifo 或 random
 //    -x 运行用户程序
 //    -c 测试控制台
 //
 //  文件系统
 //    -f 会导致物理磁盘被格式化
+//    -bc 在磁盘之上使用写回的扇区缓存，命令执行完后写回
+//    -ds 磁盘请求的调度策略：fcfs、sstf、scan 或 clook
+//    -dm 把磁盘映像映射到内存，写回策略为 none、halt 或 periodic
+//    -dg 按给定的几何参数重新创建磁盘（隐含 -f）
 //    -cp 从 UNIX 复制文件到 Nachos
 //    -p 打印 Nachos 文件到标准输出
 //    -r 从文件系统中删除 Nachos 文件
@@ -152,6 +160,10 @@ int main(int argc, char **argv)
 #endif // NETWORK
   }
 
+#ifdef FILESYS
+  synchDisk->Flush(); // 把扇区缓存写回磁盘
+#endif
+
   currentThread->Finish(); // 注意: 如果过程 "main"
                            // 返回，则程序 "nachos"
                            // 将退出（就像任何其他正常程序
@@ -74,10 +74,23 @@ void Initialize(int argc, char **argv)
 
 #ifdef USER_PROGRAM
   bool debugUserProg = FALSE; // 单步调试用户程序
+  bool translateUserProg = FALSE; // 以基本块翻译模式执行用户程序
+  char *stateFile = NULL;         // 停机时写出机器状态的文件
+  int tlbEntries = 0;             // TLB 条目数，0 表示使用编译时的设置
+  int tlbWays = 0;                // TLB 相联度
+  TLBPolicy tlbPolicy = TLBLRU;   // TLB 替换策略
 #endif
 #ifdef FILESYS_NEEDED
   bool format = FALSE; // 格式化磁盘
 #endif
+#ifdef FILESYS
+  int cacheSectors = 0; // 扇区缓存的大小，0 表示不使用缓存
+  DiskSchedPolicy diskPolicy = DiskFCFS; // 磁盘请求的调度策略
+  bool mapDisk = FALSE;                  // 把磁盘映像映射到内存
+  DiskSyncPolicy diskSync = DiskSyncHalt; // 映射时的写回策略
+  int diskTracks = 0;                    // 新磁盘的轨道数，0 表示沿用原有的
+  int diskTrackSectors = 0;              // 新磁盘的每轨扇区数
+#endif
 #ifdef NETWORK
   double rely = 1;  // 网络可靠性
   double order = 1; // 网络顺序性
@@ -108,11 +121,74 @@ void Initialize(int argc, char **argv)
 #ifdef USER_PROGRAM
     if (!strcmp(*argv, "-s"))
       debugUserProg = TRUE;
+    else if (!strcmp(*argv, "-bb"))
+      translateUserProg = TRUE;
+    else if (!strcmp(*argv, "-dump"))
+    {
+      ASSERT(argc > 1);
+      stateFile = *(argv + 1);
+      argCount = 2;
+    }
+    else if (!strcmp(*argv, "-tlb"))
+    {
+      ASSERT(argc > 3);
+      tlbEntries = atoi(*(argv + 1));
+      tlbWays = atoi(*(argv + 2));
+      if (!strcmp(*(argv + 3), "fifo"))
+        tlbPolicy = TLBFIFO;
+      else if (!strcmp(*(argv + 3), "random"))
+        tlbPolicy = TLBRandom;
+      else
+        ASSERT(!strcmp(*(argv + 3), "lru"));
+      argCount = 4;
+    }
 #endif
 #ifdef FILESYS_NEEDED
     if (!strcmp(*argv, "-f"))
       format = TRUE;
 #endif
+#ifdef FILESYS
+    if (!strcmp(*argv, "-bc"))
+    {
+      ASSERT(argc > 1);
+      cacheSectors = atoi(*(argv + 1));
+      argCount = 2;
+    }
+    else if (!strcmp(*argv, "-ds"))
+    {
+      ASSERT(argc > 1);
+      if (!strcmp(*(argv + 1), "sstf"))
+        diskPolicy = DiskSSTF;
+      else if (!strcmp(*(argv + 1), "scan"))
+        diskPolicy = DiskSCAN;
+      else if (!strcmp(*(argv + 1), "clook"))
+        diskPolicy = DiskCLOOK;
+      else
+        ASSERT(!strcmp(*(argv + 1), "fcfs"));
+      argCount = 2;
+    }
+    else if (!strcmp(*argv, "-dm"))
+    {
+      ASSERT(argc > 1);
+      mapDisk = TRUE;
+      if (!strcmp(*(argv + 1), "none"))
+        diskSync = DiskSyncNone;
+      else if (!strcmp(*(argv + 1), "periodic"))
+        diskSync = DiskSyncPeriodic;
+      else
+        ASSERT(!strcmp(*(argv + 1), "halt"));
+      argCount = 2;
+    }
+    else if (!strcmp(*argv, "-dg"))
+    {
+      ASSERT(argc > 2);
+      diskTracks = atoi(*(argv + 1));
+      diskTrackSectors = atoi(*(argv + 2));
+      ASSERT((diskTracks > 0) && (diskTrackSectors > 0));
+      format = TRUE; // 几何参数变了，旧的磁盘内容不再有效
+      argCount = 3;
+    }
+#endif
 #ifdef NETWORK
     if (!strcmp(*argv, "-n"))
     {
@@ -154,11 +230,17 @@ void Initialize(int argc, char **argv)
   CallOnUserAbort(Cleanup); // 如果用户按下 ctl-C
 
 #ifdef USER_PROGRAM
-  machine = new Machine(debugUserProg); // 这必须先执行
+  machine = new Machine(debugUserProg, translateUserProg); // 这必须先执行
+  if (tlbEntries > 0)
+    machine->UseTLB(tlbEntries, tlbWays, tlbPolicy);
+  machine->stateFile = stateFile;
 #endif
 
 #ifdef FILESYS
-  synchDisk = new SynchDisk("DISK");
+  synchDisk = new SynchDisk("DISK", cacheSectors, diskPolicy, diskTracks,
+                           diskTrackSectors);
+  if (mapDisk)
+    synchDisk->MapDisk(diskSync);
 #endif
 
 #ifdef FILESYS_NEEDED
@@ -190,7 +272,8 @@ void Cleanup()
 #endif
 
 #ifdef FILESYS
-  delete synchDisk;
+  delete synchDisk; // 只释放扇区缓存，不写回；Cleanup 也可能来自 ctl-C，
+                    // 这时调度器的状态未知，不能等待磁盘中断
 #endif
 
   delete timer;
@@ -9,7 +9,7 @@
 // 如果您在 va_start 上遇到问题，请尝试这两种替代方案
 #include <stdarg.h>
 
-static char *enableFlags = NULL; // 控制打印哪些 DEBUG 消息
+bool debugFlags[256]; // 控制打印哪些 DEBUG 消息，按标志字符索引
 
 //----------------------------------------------------------------------
 // DebugInit
@@ -23,37 +23,27 @@ static char *enableFlags = NULL; // 控制打印哪些 DEBUG 消息
 
 void DebugInit(char *flagList)
 {
-    enableFlags = flagList;
-}
+    int i;
+    bool all = (bool)(strchr(flagList, '+') != 0);
 
-//----------------------------------------------------------------------
-// DebugIsEnabled
-//      如果 DEBUG 消息的 "flag" 应该被打印，则返回 TRUE。
-//----------------------------------------------------------------------
-
-bool DebugIsEnabled(char flag)
-{
-    if (enableFlags != NULL)
-        return (bool)((strchr(enableFlags, flag) != 0) || (strchr(enableFlags, '+') != 0));
-    else
-        return FALSE;
+    for (i = 0; i < 256; i++)
+        debugFlags[i] = all;
+    for (; *flagList != '\0'; flagList++)
+        debugFlags[(unsigned char) *flagList] = TRUE;
 }
 
 //----------------------------------------------------------------------
-// DEBUG
-//      如果标志被启用，则打印调试消息。像 printf，
-//	只是前面多了一个额外的参数。
+// DebugPrint
+//      打印调试消息，并立即刷新输出。像 printf。
+//	由 DEBUG 宏在标志被启用时调用（见 utility.h）。
 //----------------------------------------------------------------------
 
-void DEBUG(char flag, const char *format, ...)
+void DebugPrint(const char *format, ...)
 {
-    if (DebugIsEnabled(flag))
-    {
-        va_list ap;
-        // 您会在这里收到一个未使用变量的消息 -- 忽略它。
-        va_start(ap, format);
-        vfprintf(stdout, format, ap);
-        va_end(ap);
-        fflush(stdout);
-    }
+    va_list ap;
+    // 您会在这里收到一个未使用变量的消息 -- 忽略它。
+    va_start(ap, format);
+    vfprintf(stdout, format, ap);
+    va_end(ap);
+    fflush(stdout);
 }
@@ -71,13 +71,34 @@ typedef void (*VoidNoArgFunctionPtr)();
 #include "sysdep.h"				
 
 // 调试例程的接口。
+//
+// DebugInit 把启用的标志展开到按字符索引的 debugFlags 表中，
+// 因此 DebugIsEnabled 只是一次查表，DEBUG 在标志未启用时
+// 只是一次分支，不会调用函数，也不会计算格式化参数。
+//
+// 通过使用 -DNODEBUG 编译可以去掉所有调试消息：DebugIsEnabled
+// 恒为 FALSE，DEBUG 语句被编译器整个删除（-d 选项不再起作用）。
 
 extern void DebugInit(char* flags);	// 启用打印调试消息
 
-extern bool DebugIsEnabled(char flag); 	// 这个调试标志是否启用？
+extern bool debugFlags[256];		// 每个调试标志是否启用
+
+inline bool DebugIsEnabled(char flag) 	// 这个调试标志是否启用？
+{
+#ifdef NODEBUG
+    return FALSE;
+#else
+    return debugFlags[(unsigned char) flag];
+#endif
+}
+
+extern void DebugPrint(const char* format, ...);	// 无条件打印调试消息
 
-extern void DEBUG (char flag, const char* format, ...);  	// 打印调试消息 
-							// 如果标志被启用
+#define DEBUG(flag, ...)	/* 打印调试消息，如果标志被启用 */	      \
+    do {								      \
+	if (DebugIsEnabled(flag))					      \
+	    DebugPrint(__VA_ARGS__);					      \
+    } while (0)
 
 //----------------------------------------------------------------------
 // ASSERT
@@ -53,9 +53,12 @@ SwapHeader (NoffHeader *noffH)
 
 AddrSpace::AddrSpace(OpenFile *executable)
 {
+    static int nextASID = 0;	// 下一个地址空间标识
     NoffHeader noffH;
     unsigned int i, size;
 
+    asid = nextASID++;
+
     executable->ReadAt((char *)&noffH, sizeof(noffH), 0);
     if ((noffH.noffMagic != NOFFMAGIC) && 
 		(WordToHost(noffH.noffMagic) == NOFFMAGIC))
@@ -116,6 +119,8 @@ AddrSpace::AddrSpace(OpenFile *executable)
 
 AddrSpace::~AddrSpace()
 {
+   if (machine->tlb != NULL)
+	machine->tlb->FlushASID(asid);	// TLB 项指向这个页表
    delete [] pageTable;
 }
 
@@ -165,11 +170,13 @@ void AddrSpace::SaveState()
 // 	在上下文切换时，恢复机器状态，以便
 // 这个地址空间可以运行。
 //
-//      目前，告诉机器在哪里找到页表。
+//      目前，告诉机器在哪里找到页表，以及TLB项使用的
+//	地址空间标识（带标识的TLB无需在切换时清空）。
 //----------------------------------------------------------------------
 
 void AddrSpace::RestoreState() 
 {
     machine->pageTable = pageTable;
     machine->pageTableSize = numPages;
+    machine->asid = asid;
 }
@@ -32,6 +32,7 @@ private:
   TranslationEntry *pageTable; // 目前假设线性页表转换
                                // 现在就这样！
   unsigned int numPages;       // 虚拟地址空间中的页数
+  int asid;                    // 地址空间标识，用作TLB项的标记
 };
 
 #endif // ADDRSPACE_H
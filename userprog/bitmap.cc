@@ -2,6 +2,9 @@
 //	管理位图的例程 -- 一个每个位可以是开或关的位数组。
 //	表示为一个整数数组。
 //
+//	查找和计数每次处理一个字（32 位），而不是逐位测试。
+//	最后一个字中超出 numBits 的位不属于位图，一律视为已设置。
+//
 
 #include "bitmap.h"
 
@@ -18,8 +21,10 @@ BitMap::BitMap(int nitems)
     numBits = nitems;
     numWords = divRoundUp(numBits, BitsInWord);
     map = new unsigned int[numWords];
-    for (int i = 0; i < numBits; i++)
-        Clear(i);
+    for (int i = 0; i < numWords; i++)
+        map[i] = 0;
+    firstFree = 0;
+    nextFit = 0;
 }
 
 //----------------------------------------------------------------------
@@ -29,7 +34,7 @@ BitMap::BitMap(int nitems)
 
 BitMap::~BitMap()
 {
-    delete map;
+    delete [] map;
 }
 
 //----------------------------------------------------------------------
@@ -56,6 +61,8 @@ void BitMap::Clear(int which)
 {
     ASSERT(which >= 0 && which < numBits);
     map[which / BitsInWord] &= ~(1 << (which % BitsInWord));
+    if (which / BitsInWord < firstFree)
+        firstFree = which / BitsInWord;
 }
 
 //----------------------------------------------------------------------
@@ -75,23 +82,120 @@ bool BitMap::Test(int which)
         return FALSE;
 }
 
+//----------------------------------------------------------------------
+// BitMap::ValidBits
+// 	返回第 "word" 个字中属于位图的位的掩码。只有当 numBits
+//	不是字长的倍数时，最后一个字才不是全部有效。
+//----------------------------------------------------------------------
+
+unsigned int BitMap::ValidBits(int word)
+{
+    if (word == numWords - 1 && (numBits % BitsInWord) != 0)
+        return (1u << (numBits % BitsInWord)) - 1;
+    return ~0u;
+}
+
 //----------------------------------------------------------------------
 // BitMap::Find
 // 	返回第一个清除的位的编号。
 //	作为副作用，设置该位（标记为使用中）。
 //	（换句话说，查找并分配一个位。）
 //
+//	从 firstFree 开始逐字查找，跳过全部设置的字；
+//	在字内用 ctz 找到最低的清除位。
+//
 //	如果没有清除的位，返回 -1。
 //----------------------------------------------------------------------
 
 int BitMap::Find()
 {
-    for (int i = 0; i < numBits; i++)
-        if (!Test(i))
+    unsigned int clear;
+
+    for (int w = firstFree; w < numWords; w++)
+    {
+        clear = ~map[w] & ValidBits(w);
+        if (clear != 0)
+        {
+            firstFree = w;
+            map[w] |= clear & -clear; // 最低的清除位
+            return w * BitsInWord + __builtin_ctz(clear);
+        }
+    }
+    firstFree = numWords;
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// BitMap::FindRange
+// 	找到连续 "n" 个清除位，设置它们，并返回第一个的编号。
+//	从上次分配的范围之后开始查找，到末尾后再从头查找
+//	（next-fit），使依次分配的范围在位图中顺序排列。
+//
+//	如果没有足够长的连续清除位，返回 -1。
+//
+//	"n" 是需要的位数
+//----------------------------------------------------------------------
+
+int BitMap::FindRange(int n)
+{
+    int start;
+
+    ASSERT(n > 0);
+    if (n > numBits)
+        return -1;
+    if (nextFit >= numBits)
+        nextFit = 0;
+    start = FindRangeIn(nextFit, numBits, n);
+    if (start == -1)
+        start = FindRangeIn(0, min(nextFit + n - 1, numBits), n);
+    if (start == -1)
+        return -1;
+    for (int i = start; i < start + n; i++)
+        map[i / BitsInWord] |= 1 << (i % BitsInWord);
+    nextFit = start + n;
+    return start;
+}
+
+//----------------------------------------------------------------------
+// BitMap::FindRangeIn
+// 	在 [from, to) 中查找连续 "n" 个清除位，返回第一个的编号，
+//	没有则返回 -1。不修改位图。
+//
+//	对齐的整字一次处理：全部设置的字使当前的连续段中断，
+//	全部清除的字使其增长一个字长。
+//----------------------------------------------------------------------
+
+int BitMap::FindRangeIn(int from, int to, int n)
+{
+    int run = 0; // 以 i 结尾的连续清除位数
+    int i = from;
+
+    while (i < to)
+    {
+        if (i % BitsInWord == 0 && i + BitsInWord <= to)
         {
-            Mark(i);
-            return i;
+            unsigned int word = map[i / BitsInWord];
+            if (word == ~0u)
+            {
+                run = 0;
+                i += BitsInWord;
+                continue;
+            }
+            if (word == 0)
+            {
+                if (run + BitsInWord >= n)
+                    return i - run;
+                run += BitsInWord;
+                i += BitsInWord;
+                continue;
+            }
         }
+        if (map[i / BitsInWord] & (1 << (i % BitsInWord)))
+            run = 0;
+        else if (++run == n)
+            return i - n + 1;
+        i++;
+    }
     return -1;
 }
 
@@ -105,9 +209,8 @@ int BitMap::NumClear()
 {
     int count = 0;
 
-    for (int i = 0; i < numBits; i++)
-        if (!Test(i))
-            count++;
+    for (int w = 0; w < numWords; w++)
+        count += __builtin_popcount(~map[w] & ValidBits(w));
     return count;
 }
 
@@ -140,6 +243,8 @@ void BitMap::Print()
 void BitMap::FetchFrom(OpenFile *file)
 {
     file->ReadAt((char *)map, numWords * sizeof(unsigned), 0);
+    firstFree = 0;
+    nextFit = 0;
 }
 
 //----------------------------------------------------------------------
@@ -2,7 +2,8 @@
 //	定义位图的数据结构 -- 一个每个位可以是开或关的位数组。
 //
 //	表示为一个无符号整数数组，我们对其进行
-//	模运算以找到我们感兴趣的位。
+//	模运算以找到我们感兴趣的位。查找和计数按字进行：
+//	取反后用 ctz 找第一个清除位，用 popcount 计数。
 //
 //	位图可以根据管理的位数进行参数化。
 
@@ -37,6 +38,9 @@ class BitMap {
     int Find();            	// 返回一个清除位的编号，并作为副作用
 				// 设置该位。
 				// 如果没有清除位，返回-1。
+    int FindRange(int n);	// 找到连续“n”个清除位，设置它们并
+				// 返回第一个的编号；没有则返回-1。
+				// 从上次分配的位置之后开始查找（next-fit）
     int NumClear();		// 返回清除位的数量
 
     void Print();		// 打印位图的内容
@@ -52,6 +56,14 @@ class BitMap {
 					// （如果numBits不是
 					//  位数的倍数，则向上取整）
     unsigned int *map;			// 位存储
+    int firstFree;			// 在此之前的字都已全部设置，
+					// Find 从这里开始查找
+    int nextFit;			// FindRange 下次开始查找的位，
+					// 每次分配后移到所分配范围之后
+
+    unsigned int ValidBits(int word);	// 字中属于位图的位
+    int FindRangeIn(int from, int to, int n);
+					// 在 [from, to) 中找连续 n 个清除位
 };
 
 #endif // BITMAP_H